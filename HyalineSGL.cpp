@@ -1,195 +1,467 @@
+#include <algorithm>
 #include <atomic>
 #include <thread>
 #include <vector>
 #include <iostream>
 #include <random>
-#include <unordered_map>
 #include <optional>
-#include <cassert>
+#include <string>
+#include <unordered_map>
 
-// Slot structure for maintaining retirement lists
-struct Slot {
-    std::atomic<int> refCount; // Global reference counter for this slot
-    std::atomic<void*> head;  // Head of the retired list
+#include "flat_combining.h"
+#include "hyaline.h"
+#include "michael_hashmap.h"
+#include "reclaimer.h"
+#include "sharded_map.h"
+#include "spin_locks.h"
+#include "split_ordered_map.h"
+#include "swiss_table.h"
 
-    Slot() : refCount(0), head(nullptr) {}
-};
+// SGLUnorderedMap Implementation
+
+// How get reaches the table: under the lock, by a plain lock-free walk, or
+// by a walk that retries if any write overlapped it (seqlock)
+enum class GetMode { Locked, LockFree, Seqlock };
+
+inline const char* getModeName(GetMode mode) {
+    return mode == GetMode::Locked ? "locked" : mode == GetMode::LockFree ? "lock-free" : "seqlock";
+}
+
+// Backing tables for SGLUnorderedMap. Writes always come in under the map's
+// lock; kConcurrentReads says whether walk() may run without it, and
+// kRetires whether writers hand anything to the reclaimer.
+
+// std::unordered_map, updated in place under the lock. The baseline: nothing
+// is ever retired, and gets always take the lock.
+template <class K, class V>
+class UnorderedBackend {
+private:
+    std::unordered_map<K, V> m;
 
-class Hyaline {
 public:
-    Hyaline(int numSlots) : slots(numSlots), slotCount(numSlots) {}
+    static constexpr bool kConcurrentReads = false;
+    static constexpr bool kRetires = false;
+    static const char* name() { return "std::unordered_map"; }
 
-    // Enter the critical section
-    void* enter(int slotId) {
-        Slot& slot = slots[slotId];
-        slot.refCount.fetch_add(1, std::memory_order_relaxed);
-        return slot.head.load(std::memory_order_acquire);
+    explicit UnorderedBackend(HyalineReclaimer&) {}
+
+    bool insert(K key, V val, int) { return m.emplace(key, val).second; }
+
+    std::optional<V> put(K key, V val, int) {
+        auto v = m.emplace(key, val);
+        if (v.second) return {};
+        V old = v.first->second;
+        v.first->second = val;
+        return old;
+    }
+
+    std::optional<V> replace(K key, V val, int) {
+        auto v = m.find(key);
+        if (v == m.end()) return {};
+        V old = v->second;
+        v->second = val;
+        return old;
+    }
+
+    std::optional<V> remove(K key, int) {
+        auto v = m.find(key);
+        if (v == m.end()) return {};
+        V old = v->second;
+        m.erase(v);
+        return old;
     }
 
-    // Leave the critical section
-    void leave(int slotId, void* handle) {
-        Slot& slot = slots[slotId];
-        auto head = slot.head.load(std::memory_order_acquire);
-        auto ref = slot.refCount.fetch_sub(1, std::memory_order_release);
+    std::optional<V> find(const K& key) {
+        auto v = m.find(key);
+        if (v != m.end()) return v->second;
+        return {};
+    }
 
-        if (ref == 1 && head) { // This thread may need to handle reclamation
-            traverseAndReclaim(slot, head);
+    // The node-based map gives no address to prefetch before the lookup itself
+    void prefetch(const K&) {}
+};
+
+// Chained table whose entries are immutable and published through atomic
+// bucket pointers, so readers can walk the chains inside a Hyaline critical
+// section. Writers retire every entry they replace or unlink, and the whole
+// table when it grows.
+template <class K, class V>
+class ChainedTable {
+private:
+    struct Entry : HyalineReclaimer::Node {
+        const K key;
+        const V val;
+        std::atomic<Entry*> next;
+
+        Entry(K k, V v, Entry* n) : key(k), val(v), next(n) {}
+    };
+
+    struct Buckets : HyalineReclaimer::Node {
+        const size_t mask;
+        std::atomic<Entry*>* const heads;
+        size_t count = 0;
+
+        explicit Buckets(size_t size) : mask(size - 1), heads(new std::atomic<Entry*>[size]()) {}
+        ~Buckets() { delete[] heads; }
+    };
+
+    // The link pointing at key's entry, or at the null ending its chain
+    std::atomic<Entry*>* findLink(Buckets* b, const K& key) {
+        std::atomic<Entry*>* link = &b->heads[std::hash<K>()(key) & b->mask];
+        Entry* e;
+        while ((e = link->load(std::memory_order_relaxed)) && !(e->key == key)) {
+            link = &e->next;
         }
+        return link;
     }
 
-    // Retire a batch of objects
-    void retire(void* batchHead, int slotId) {
-        Slot& slot = slots[slotId];
+    void add(K key, V val, int tid) {
+        Buckets* b = buckets.load(std::memory_order_relaxed);
+        std::atomic<Entry*>& head = b->heads[std::hash<K>()(key) & b->mask];
+        head.store(new Entry(key, val, head.load(std::memory_order_relaxed)), std::memory_order_release);
+        if (++b->count > b->mask + 1) grow(tid);
+    }
 
-        void* prevHead = nullptr;
-        do {
-            prevHead = slot.head.load(std::memory_order_acquire);
-            *reinterpret_cast<void**>(batchHead) = prevHead;
-        } while (!slot.head.compare_exchange_weak(prevHead, batchHead, std::memory_order_release));
+    // Copies every entry into a table twice the size, then retires the old
+    // table and entries, which lock-free readers may still be walking
+    void grow(int tid) {
+        Buckets* old = buckets.load(std::memory_order_relaxed);
+        Buckets* bigger = new Buckets((old->mask + 1) * 2);
+        for (size_t i = 0; i <= old->mask; ++i) {
+            for (Entry* e = old->heads[i].load(std::memory_order_relaxed); e; e = e->next.load(std::memory_order_relaxed)) {
+                std::atomic<Entry*>& head = bigger->heads[std::hash<K>()(e->key) & bigger->mask];
+                head.store(new Entry(e->key, e->val, head.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+            }
+        }
+        bigger->count = old->count;
+        buckets.store(bigger, std::memory_order_release);
+        for (size_t i = 0; i <= old->mask; ++i) {
+            for (Entry* e = old->heads[i].load(std::memory_order_relaxed); e;) {
+                Entry* next = e->next.load(std::memory_order_relaxed);
+                reclaimer.retire(e, tid);
+                e = next;
+            }
+        }
+        reclaimer.retire(old, tid);
     }
 
-private:
-    std::vector<Slot> slots;
-    const int slotCount;
+    HyalineReclaimer& reclaimer;
+    std::atomic<Buckets*> buckets;
+
+public:
+    static constexpr bool kConcurrentReads = true;
+    static constexpr bool kRetires = true;
+    static const char* name() { return "chained"; }
 
-    // Traverse and reclaim retired objects
-    void traverseAndReclaim(Slot& slot, void* handle) {
-        void* current = slot.head.load(std::memory_order_acquire);
+    explicit ChainedTable(HyalineReclaimer& reclaimer) : reclaimer(reclaimer), buckets(new Buckets(16)) {}
 
-        while (current && current != handle) {
-            void* next = *reinterpret_cast<void**>(current);
-            delete reinterpret_cast<char*>(current); // Assuming objects are dynamically allocated
-            current = next;
+    ~ChainedTable() {
+        Buckets* b = buckets.load();
+        for (size_t i = 0; i <= b->mask; ++i) {
+            for (Entry* e = b->heads[i].load(); e;) {
+                Entry* next = e->next.load();
+                delete e;
+                e = next;
+            }
         }
+        delete b;
+    }
 
-        // Reset the head to indicate completion
-        if (slot.refCount.load(std::memory_order_acquire) == 0) {
-            slot.head.store(nullptr, std::memory_order_release);
+    bool insert(K key, V val, int tid) {
+        if (findLink(buckets.load(std::memory_order_relaxed), key)->load(std::memory_order_relaxed)) return false;
+        add(key, val, tid);
+        return true;
+    }
+
+    std::optional<V> put(K key, V val, int tid) {
+        std::atomic<Entry*>* link = findLink(buckets.load(std::memory_order_relaxed), key);
+        if (Entry* e = link->load(std::memory_order_relaxed)) {
+            link->store(new Entry(key, val, e->next.load(std::memory_order_relaxed)), std::memory_order_release);
+            V old = e->val;
+            reclaimer.retire(e, tid);
+            return old;
         }
+        add(key, val, tid);
+        return {};
     }
-};
 
-// SGLUnorderedMap Implementation
+    std::optional<V> replace(K key, V val, int tid) {
+        std::atomic<Entry*>* link = findLink(buckets.load(std::memory_order_relaxed), key);
+        Entry* e = link->load(std::memory_order_relaxed);
+        if (!e) return {};
+        link->store(new Entry(key, val, e->next.load(std::memory_order_relaxed)), std::memory_order_release);
+        V old = e->val;
+        reclaimer.retire(e, tid);
+        return old;
+    }
+
+    std::optional<V> remove(K key, int tid) {
+        Buckets* b = buckets.load(std::memory_order_relaxed);
+        std::atomic<Entry*>* link = findLink(b, key);
+        Entry* e = link->load(std::memory_order_relaxed);
+        if (!e) return {};
+        link->store(e->next.load(std::memory_order_relaxed), std::memory_order_release);
+        --b->count;
+        V old = e->val;
+        reclaimer.retire(e, tid);
+        return old;
+    }
+
+    std::optional<V> find(const K& key) {
+        if (Entry* e = findLink(buckets.load(std::memory_order_relaxed), key)->load(std::memory_order_relaxed)) {
+            return e->val;
+        }
+        return {};
+    }
+
+    // Under the lock or inside a critical section
+    void prefetch(const K& key) {
+        Buckets* b = buckets.load(std::memory_order_acquire);
+        __builtin_prefetch(&b->heads[std::hash<K>()(key) & b->mask]);
+    }
 
+    // Without the lock, inside a critical section
+    std::optional<V> walk(const K& key) {
+        Buckets* b = buckets.load(std::memory_order_acquire);
+        Entry* e = b->heads[std::hash<K>()(key) & b->mask].load(std::memory_order_acquire);
+        while (e && !(e->key == key)) {
+            e = e->next.load(std::memory_order_acquire);
+        }
+        if (e) return e->val;
+        return {};
+    }
+};
+
+// Swiss-table open addressing (swiss_table.h): entries inline, no
+// allocation or retire per entry, and the shortest critical sections, but
+// gets always take the lock
 template <class K, class V>
+class SwissBackend {
+private:
+    SwissTable<K, V> table;
+
+public:
+    static constexpr bool kConcurrentReads = false;
+    static constexpr bool kRetires = false;
+    static const char* name() { return "swiss"; }
+
+    explicit SwissBackend(HyalineReclaimer&) {}
+
+    bool insert(K key, V val, int) { return table.emplace(key, val).second; }
+
+    std::optional<V> put(K key, V val, int) {
+        auto slot = table.emplace(key, val);
+        if (slot.second) return {};
+        V old = *slot.first;
+        *slot.first = val;
+        return old;
+    }
+
+    std::optional<V> replace(K key, V val, int) {
+        V* v = table.find(key);
+        if (!v) return {};
+        V old = *v;
+        *v = val;
+        return old;
+    }
+
+    std::optional<V> remove(K key, int) {
+        V* v = table.find(key);
+        if (!v) return {};
+        V old = *v;
+        table.erase(key);
+        return old;
+    }
+
+    std::optional<V> find(const K& key) {
+        if (V* v = table.find(key)) return *v;
+        return {};
+    }
+
+    void prefetch(const K& key) { table.prefetch(key); }
+};
+
+// Writers serialize on one lock, and run inside a Hyaline critical section
+// only if the table retires what they replace. Lock is one of the policies in
+// spin_locks.h; Table is UnorderedBackend, ChainedTable or SwissBackend.
+template <class K, class V, class Lock = TASLock, template <class, class> class Table = UnorderedBackend>
 class SGLUnorderedMap {
 private:
-    // Simple test and set lock
     inline void lockAcquire(int tid) {
-        int unlk = -1;
-        while (!lk.compare_exchange_strong(unlk, tid, std::memory_order_acq_rel)) {
-            unlk = -1; // compare_exchange puts the old value into unlk, so set it back
-        }
-        assert(lk.load() == tid);
+        lk.lock(tid);
     }
 
     inline void lockRelease(int tid) {
-        assert(lk == tid);
-        int unlk = -1;
-        lk.store(unlk, std::memory_order_release);
+        lk.unlock(tid);
     }
 
-    std::unordered_map<K, V>* m = nullptr;
-    std::atomic<int> lk;
+    // Writers hold the sequence count odd while they change anything, so an
+    // optimistic get can tell that it overlapped a write
+    inline void beginWrite(int tid) {
+        if constexpr (Table<K, V>::kRetires) reclaimer.enter(tid);
+        lockAcquire(tid);
+        if constexpr (Table<K, V>::kConcurrentReads) {
+            seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+    }
 
-public:
-    SGLUnorderedMap() {
-        m = new std::unordered_map<K, V>();
-        lk.store(-1, std::memory_order_release);
+    inline void endWrite(int tid) {
+        if constexpr (Table<K, V>::kConcurrentReads) {
+            seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+        lockRelease(tid);
+        if constexpr (Table<K, V>::kRetires) reclaimer.leave(tid);
+    }
+
+    // Inside a critical section
+    std::optional<V> optimisticWalk(const K& key) {
+        if (getMode == GetMode::LockFree) return table.walk(key);
+        // Retry until no write overlapped the walk; the critical section
+        // keeps whatever a concurrent writer unlinks from being freed meanwhile
+        int spins = 0;
+        while (true) {
+            uint64_t before = seq.load(std::memory_order_acquire);
+            if (before & 1) {
+                spinWait(spins);
+                continue;
+            }
+            std::optional<V> res = table.walk(key);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == before) return res;
+        }
     }
 
-    ~SGLUnorderedMap() {
-        delete m;
+    std::optional<V> optimisticGet(const K& key, int tid) {
+        reclaimer.enter(tid);
+        std::optional<V> res = optimisticWalk(key);
+        reclaimer.leave(tid);
+        return res;
     }
 
+    HyalineReclaimer& reclaimer;
+    Table<K, V> table;
+    Lock lk;
+    alignas(64) std::atomic<uint64_t> seq{0};
+    const GetMode getMode;
+
+public:
+    // Tables without concurrent reads serve every get under the lock
+    SGLUnorderedMap(HyalineReclaimer& reclaimer, int threads, GetMode getMode = GetMode::Locked)
+        : reclaimer(reclaimer), table(reclaimer), lk(threads),
+          getMode(Table<K, V>::kConcurrentReads ? getMode : GetMode::Locked) {}
+
     bool insert(K key, V val, int tid) {
-        lockAcquire(tid);
-        auto v = m->emplace(key, val);
-        lockRelease(tid);
-        return v.second;
+        beginWrite(tid);
+        bool inserted = table.insert(key, val, tid);
+        endWrite(tid);
+        return inserted;
     }
 
     std::optional<V> put(K key, V val, int tid) {
-        std::optional<V> res = {};
-        lockAcquire(tid);
-        auto it = m->find(key);
-        if (it != m->end()) {
-            res = it->second;
-        }
-        (*m)[key] = val;
-        lockRelease(tid);
+        beginWrite(tid);
+        std::optional<V> res = table.put(key, val, tid);
+        endWrite(tid);
         return res;
     }
 
     std::optional<V> replace(K key, V val, int tid) {
-        std::optional<V> res = {};
-        lockAcquire(tid);
-        auto v = m->find(key);
-        if (v != m->end()) {
-            res = v->second;
-            (*m)[key] = val;
-        }
-        lockRelease(tid);
+        beginWrite(tid);
+        std::optional<V> res = table.replace(key, val, tid);
+        endWrite(tid);
         return res;
     }
 
     std::optional<V> remove(K key, int tid) {
-        std::optional<V> res = {};
-        lockAcquire(tid);
-        auto v = m->find(key);
-        if (v != m->end()) {
-            res = v->second;
-            m->erase(key);
-        }
-        lockRelease(tid);
+        beginWrite(tid);
+        std::optional<V> res = table.remove(key, tid);
+        endWrite(tid);
         return res;
     }
 
     std::optional<V> get(K key, int tid) {
-        std::optional<V> res = {};
-        lockAcquire(tid);
-        auto v = m->find(key);
-        if (v != m->end()) {
-            res = v->second;
+        if constexpr (Table<K, V>::kConcurrentReads) {
+            if (getMode != GetMode::Locked) return optimisticGet(key, tid);
         }
+        lockAcquire(tid);
+        std::optional<V> res = table.find(key);
         lockRelease(tid);
         return res;
     }
-};
 
-// Example usage of SGLUnorderedMap with Hyaline
-int main(int argc, char* argv[]) {
-    int threads;
-    if (argc == 2) {
-        threads = std::stoi(argv[1]);
+    // Looks up keys[0..count) into out[0..count) under one lock acquisition,
+    // or one critical section for lock-free and seqlock gets. Every bucket is
+    // prefetched before the first probe, so the misses overlap.
+    void multiGet(const K* keys, size_t count, std::optional<V>* out, int tid) {
+        if constexpr (Table<K, V>::kConcurrentReads) {
+            if (getMode != GetMode::Locked) {
+                reclaimer.enter(tid);
+                for (size_t i = 0; i < count; ++i) table.prefetch(keys[i]);
+                for (size_t i = 0; i < count; ++i) out[i] = optimisticWalk(keys[i]);
+                reclaimer.leave(tid);
+                return;
+            }
+        }
+        lockAcquire(tid);
+        for (size_t i = 0; i < count; ++i) table.prefetch(keys[i]);
+        for (size_t i = 0; i < count; ++i) out[i] = table.find(keys[i]);
+        lockRelease(tid);
     }
-    else {
-        threads = 4;
+
+    // Puts every pair in one write section; returns how many keys were new
+    size_t multiPut(const std::pair<K, V>* items, size_t count, int tid) {
+        size_t added = 0;
+        beginWrite(tid);
+        for (size_t i = 0; i < count; ++i) table.prefetch(items[i].first);
+        for (size_t i = 0; i < count; ++i) {
+            if (!table.put(items[i].first, items[i].second, tid)) ++added;
+        }
+        endWrite(tid);
+        return added;
     }
-    std::cout << "The thread count is: " << threads << std::endl;
-    const int objects = 10000; // Number of objects to operate on
-    auto start_time = std::chrono::high_resolution_clock::now();
-    Hyaline hyaline(threads);
-    SGLUnorderedMap<int, int> map;
 
+    // Removes every key in one write section; returns how many were present
+    size_t multiRemove(const K* keys, size_t count, int tid) {
+        size_t removed = 0;
+        beginWrite(tid);
+        for (size_t i = 0; i < count; ++i) table.prefetch(keys[i]);
+        for (size_t i = 0; i < count; ++i) {
+            if (table.remove(keys[i], tid)) ++removed;
+        }
+        endWrite(tid);
+        return removed;
+    }
+};
+
+// Runs the benchmark loop against any map with the SGLUnorderedMap interface;
+// reads is the percentage of operations that are gets, the rest alternate
+// between insert and remove
+template <class Map>
+void run(Map& map, int threads, int objects, int reads) {
+    auto start_time = std::chrono::high_resolution_clock::now();
     std::vector<std::thread> workers;
+    std::atomic<long> executed{0};
 
     for (int i = 0; i < threads; ++i) {
-        workers.emplace_back([&map, &hyaline, i, objects, threads]() {
+        workers.emplace_back([&map, &executed, i, objects, threads, reads]() {
             std::random_device rd;
             std::mt19937 gen(rd());
             std::uniform_int_distribution<> dis(1, objects);
+            std::uniform_int_distribution<> percent(0, 99);
 
             for (int j = 0; j < objects / threads; ++j) {
                 int key = dis(gen);
                 int value = dis(gen);
 
-                if (j % 2 == 0) {
+                if (reads > 0 && percent(gen) < reads) {
+                    map.get(key, i);
+                } else if (j % 2 == 0) {
                     map.insert(key, value, i);
                 } else {
                     map.remove(key, i);
                 }
             }
+            executed.fetch_add(objects / threads);
         });
     }
 
@@ -199,7 +471,154 @@ int main(int argc, char* argv[]) {
 
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end_time - start_time;
-    double throughput = static_cast<double>(objects) / elapsed.count();
+    double throughput = static_cast<double>(executed.load()) / elapsed.count();
     std::cout << "Threads: " << threads << " | Throughput: " << throughput << " ops/sec" << std::endl;
+}
+
+// Same mix, but in batches of keys: gets go through multiGet, and updates
+// alternate between a multiPut and a multiRemove, so the lock and critical
+// section are paid once per batch; throughput counts keys
+template <class Map>
+void runBatched(Map& map, int threads, int objects, int reads, int batch) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    std::atomic<long> executed{0};
+
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&map, &executed, i, objects, threads, reads, batch]() {
+            std::random_device rd;
+            std::mt19937 gen(rd());
+            std::uniform_int_distribution<> dis(1, objects);
+            std::uniform_int_distribution<> percent(0, 99);
+            std::vector<int> keys(batch);
+            std::vector<std::optional<int>> values(batch);
+            std::vector<std::pair<int, int>> items(batch);
+
+            // The last batch is cut short so every thread runs as many keys as in run
+            long done = 0;
+            for (int j = 0, round = 0; j < objects / threads; j += batch, ++round) {
+                int n = std::min(batch, objects / threads - j);
+                for (int k = 0; k < n; ++k) keys[k] = dis(gen);
+
+                if (reads > 0 && percent(gen) < reads) {
+                    map.multiGet(keys.data(), n, values.data(), i);
+                } else if (round % 2 == 0) {
+                    for (int k = 0; k < n; ++k) items[k] = {keys[k], dis(gen)};
+                    map.multiPut(items.data(), n, i);
+                } else {
+                    map.multiRemove(keys.data(), n, i);
+                }
+                done += n;
+            }
+            executed.fetch_add(done);
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    double throughput = static_cast<double>(executed.load()) / elapsed.count();
+    std::cout << "Threads: " << threads << " | Batch: " << batch << " | Throughput: " << throughput << " keys/sec"
+              << std::endl;
+}
+
+template <class Lock, template <class, class> class Table>
+void runLocked(int threads, int objects, int reads, GetMode getMode, int batch = 0) {
+    if (!Table<int, int>::kConcurrentReads) getMode = GetMode::Locked;
+    std::cout << "Map: single global lock (" << Lock::name() << ", " << Table<int, int>::name() << " table), "
+              << getModeName(getMode) << " gets" << std::endl;
+    HyalineReclaimer reclaimer(threads);
+    SGLUnorderedMap<int, int, Lock, Table> map(reclaimer, threads, getMode);
+    if (batch > 0) runBatched(map, threads, objects, reads, batch);
+    else run(map, threads, objects, reads);
+}
+
+// std::unordered_map unless asked for the Swiss table, or for gets that skip
+// the lock, which need the chained table
+template <class Lock>
+void runLocked(int threads, int objects, int reads, GetMode getMode, bool swiss, int batch = 0) {
+    if (swiss) runLocked<Lock, SwissBackend>(threads, objects, reads, getMode, batch);
+    else if (getMode != GetMode::Locked) runLocked<Lock, ChainedTable>(threads, objects, reads, getMode, batch);
+    else runLocked<Lock, UnorderedBackend>(threads, objects, reads, getMode, batch);
+}
+
+// Example usage of SGLUnorderedMap with Hyaline
+// ./HyalineSGL [threads] [lockfree | splitorder | sharded | cas | ticket | mcs | clh | combining | readmodes]
+//              [shards=N] [reads=percent] [get=lockfree | get=seqlock] [table=swiss] [batch=N]
+int main(int argc, char* argv[]) {
+    int threads;
+    if (argc >= 2) {
+        threads = std::stoi(argv[1]);
+    }
+    else {
+        threads = 4;
+    }
+    std::string kind = "sgl";
+    int shards = 64;
+    int reads = 0;
+    GetMode getMode = GetMode::Locked;
+    bool swiss = false;
+    int batch = 0;
+    for (int a = 2; a < argc; ++a) {
+        std::string option = argv[a];
+        if (option.rfind("shards=", 0) == 0) shards = std::stoi(option.substr(7));
+        else if (option.rfind("reads=", 0) == 0) reads = std::stoi(option.substr(6));
+        else if (option == "get=lockfree") getMode = GetMode::LockFree;
+        else if (option == "get=seqlock") getMode = GetMode::Seqlock;
+        else if (option == "table=swiss") swiss = true;
+        else if (option.rfind("batch=", 0) == 0) batch = std::stoi(option.substr(6));
+        else kind = option;
+    }
+    std::cout << "The thread count is: " << threads << " | Reads: " << reads << "%" << std::endl;
+    const int objects = 10000; // Number of objects to operate on
+
+    if (kind == "lockfree") {
+        std::cout << "Map: Michael lock-free hash map" << std::endl;
+        HyalineReclaimer reclaimer(threads);
+        MichaelHashMap<int, int, HyalineReclaimer> map(reclaimer);
+        run(map, threads, objects, reads);
+    } else if (kind == "splitorder") {
+        std::cout << "Map: split-ordered hash map" << std::endl;
+        HyalineReclaimer reclaimer(threads);
+        SplitOrderedMap<int, int, HyalineReclaimer> map(reclaimer);
+        run(map, threads, objects, reads);
+    } else if (kind == "sharded") {
+        std::cout << "Map: " << shards << " locked shards" << std::endl;
+        ShardedUnorderedMap<int, int> map(shards);
+        run(map, threads, objects, reads);
+    } else if (kind == "combining") {
+        std::cout << "Map: single global lock, flat combining" << std::endl;
+        HyalineReclaimer reclaimer(threads);
+        if (swiss) {
+            FlatCombining<SGLUnorderedMap<int, int, TASLock, SwissBackend>> map(threads, reclaimer, threads);
+            run(map, threads, objects, reads);
+            std::cout << "Average batch: " << map.averageBatch() << " ops" << std::endl;
+        } else {
+            FlatCombining<SGLUnorderedMap<int, int>> map(threads, reclaimer, threads);
+            run(map, threads, objects, reads);
+            std::cout << "Average batch: " << map.averageBatch() << " ops" << std::endl;
+        }
+    } else if (kind == "readmodes") {
+        // Each get mode of the single-global-lock map, from balanced to read-mostly
+        for (int r : {50, 75, 90, 95, 99}) {
+            for (GetMode mode : {GetMode::Locked, GetMode::LockFree, GetMode::Seqlock}) {
+                std::cout << "Reads: " << r << "% | ";
+                runLocked<TASLock>(threads, objects, r, mode, false);
+            }
+        }
+    } else if (kind == "cas") {
+        runLocked<CASLock>(threads, objects, reads, getMode, swiss, batch);
+    } else if (kind == "ticket") {
+        runLocked<TicketLock>(threads, objects, reads, getMode, swiss, batch);
+    } else if (kind == "mcs") {
+        runLocked<MCSLock>(threads, objects, reads, getMode, swiss, batch);
+    } else if (kind == "clh") {
+        runLocked<CLHLock>(threads, objects, reads, getMode, swiss, batch);
+    } else {
+        runLocked<TASLock>(threads, objects, reads, getMode, swiss, batch);
+    }
     return 0;
 }
@@ -0,0 +1,12 @@
+#include "art_olc.h"
+#include "set_bench.h"
+
+// Adaptive radix tree with optimistic lock coupling under each reclamation
+// scheme. Readers never write shared memory, and nodes replaced when they
+// grow, shrink or merge are the only thing retired.
+int main(int argc, char* argv[]) {
+    SetWorkload workload = parseSetWorkload(argc, argv);
+    runSetWorkload<ArtOLC, HyalineReclaimer>(workload);
+    runSetWorkload<ArtOLC, IBRReclaimer>(workload);
+    return 0;
+}
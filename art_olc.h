@@ -0,0 +1,532 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Adaptive radix tree with optimistic lock coupling (Leis et al., DaMoN 2016).
+// Keys are the 4 big-endian bytes of an int (sign bit flipped so byte order
+// matches int order). Inner nodes come in four sizes, Node4/16/48/256, and are
+// replaced by the next size up or down as they fill or empty; a one-child
+// Node4 is merged into that child. Leaves are tagged keys stored directly in
+// the child slots.
+//
+// Every node has a version word. Readers take no locks: they note the
+// version, read, and restart if it has changed. Writers lock only the nodes
+// they modify by bumping the version. A replaced node is marked obsolete
+// and retired through the reclaimer, since optimistic readers may still be
+// on it.
+template <class Reclaimer>
+class ArtOLC {
+public:
+    explicit ArtOLC(Reclaimer& reclaimer) : reclaimer(reclaimer), root(new Node256()) {}
+
+    ~ArtOLC() {
+        deleteTree(root);
+    }
+
+    bool insert(int k, int tid) {
+        reclaimer.enter(tid);
+        bool inserted = insertKey(bits(k), tid);
+        reclaimer.leave(tid);
+        return inserted;
+    }
+
+    bool remove(int k, int tid) {
+        reclaimer.enter(tid);
+        bool removed = removeKey(bits(k), tid);
+        reclaimer.leave(tid);
+        return removed;
+    }
+
+    bool contains(int k, int tid) {
+        reclaimer.enter(tid);
+        bool found = lookup(bits(k));
+        reclaimer.leave(tid);
+        return found;
+    }
+
+private:
+    using Slot = std::atomic<uintptr_t>; // Node*, tagged leaf, or 0
+    using Byte = std::atomic<uint8_t>;
+
+    static constexpr uint64_t kObsolete = 1;
+    static constexpr uint64_t kLocked = 2;
+    static constexpr uintptr_t kLeaf = 1;
+
+    // Fields are atomics only so that optimistic reads racing with a writer
+    // are defined; the version check decides whether what was read counts
+    struct Node : Reclaimer::Node {
+        std::atomic<uint64_t> version{0};
+        std::atomic<uint16_t> count{0};
+        std::atomic<uint8_t> prefixLength{0};
+        std::atomic<uint32_t> prefix{0}; // Up to 3 bytes, first byte highest
+
+        void copyHeader(const Node* from) {
+            count.store(from->count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            prefixLength.store(from->prefixLength.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            prefix.store(from->prefix.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        virtual uintptr_t get(uint8_t byte) const = 0;
+        virtual void add(uint8_t byte, uintptr_t child) = 0; // Byte absent, node not full
+        virtual void change(uint8_t byte, uintptr_t child) = 0;
+        virtual void erase(uint8_t byte) = 0;
+        virtual bool full() const = 0;
+        virtual bool underfull() const = 0;     // Would fit the next size down after one erase
+        virtual Node* grow() const = 0;         // Copy into the next size up
+        virtual Node* shrink() const = 0;       // Copy into the next size down
+        virtual uintptr_t first(uint8_t& byte) const = 0; // Some child, for merging a one-child node
+    };
+
+    // Sorted keys, linear search; Node16 differs only in capacity
+    template <int N>
+    struct SmallNode : Node {
+        Byte keys[N];
+        Slot children[N];
+
+        SmallNode() {
+            for (int i = 0; i < N; ++i) {
+                keys[i].store(0, std::memory_order_relaxed);
+                children[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        int size() const {
+            int n = this->count.load(std::memory_order_relaxed);
+            return n < N ? n : N;
+        }
+
+        uintptr_t get(uint8_t byte) const override {
+            int n = size();
+            for (int i = 0; i < n; ++i) {
+                if (keys[i].load(std::memory_order_relaxed) == byte) return children[i].load(std::memory_order_relaxed);
+            }
+            return 0;
+        }
+
+        void add(uint8_t byte, uintptr_t child) override {
+            int n = size();
+            int pos = 0;
+            while (pos < n && keys[pos].load(std::memory_order_relaxed) < byte) ++pos;
+            for (int i = n; i > pos; --i) {
+                keys[i].store(keys[i - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                children[i].store(children[i - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            keys[pos].store(byte, std::memory_order_relaxed);
+            children[pos].store(child, std::memory_order_relaxed);
+            this->count.store(n + 1, std::memory_order_relaxed);
+        }
+
+        void change(uint8_t byte, uintptr_t child) override {
+            for (int i = 0; i < size(); ++i) {
+                if (keys[i].load(std::memory_order_relaxed) == byte) children[i].store(child, std::memory_order_relaxed);
+            }
+        }
+
+        void erase(uint8_t byte) override {
+            int n = size();
+            int pos = 0;
+            while (pos < n && keys[pos].load(std::memory_order_relaxed) != byte) ++pos;
+            if (pos == n) return;
+            for (int i = pos; i + 1 < n; ++i) {
+                keys[i].store(keys[i + 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                children[i].store(children[i + 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            this->count.store(n - 1, std::memory_order_relaxed);
+        }
+
+        bool full() const override { return size() == N; }
+        bool underfull() const override { return N == 16 && size() <= 3; }
+
+        Node* grow() const override {
+            Node* big = N == 4 ? static_cast<Node*>(new SmallNode<16>()) : static_cast<Node*>(new Node48());
+            copyTo(big);
+            return big;
+        }
+
+        Node* shrink() const override {
+            Node* small = new SmallNode<4>();
+            copyTo(small);
+            return small;
+        }
+
+        uintptr_t first(uint8_t& byte) const override {
+            byte = keys[0].load(std::memory_order_relaxed);
+            return children[0].load(std::memory_order_relaxed);
+        }
+
+        void copyTo(Node* to) const {
+            to->prefixLength.store(this->prefixLength.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            to->prefix.store(this->prefix.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            for (int i = 0; i < size(); ++i) {
+                to->add(keys[i].load(std::memory_order_relaxed), children[i].load(std::memory_order_relaxed));
+            }
+        }
+    };
+
+    using Node4 = SmallNode<4>;
+    using Node16 = SmallNode<16>;
+
+    struct Node48 : Node {
+        static constexpr uint8_t kEmpty = 48;
+        Byte index[256]; // Slot in children, or kEmpty
+        Slot children[48];
+
+        Node48() {
+            for (auto& i : index) i.store(kEmpty, std::memory_order_relaxed);
+            for (auto& c : children) c.store(0, std::memory_order_relaxed);
+        }
+
+        uintptr_t get(uint8_t byte) const override {
+            uint8_t i = index[byte].load(std::memory_order_relaxed);
+            return i == kEmpty ? 0 : children[i].load(std::memory_order_relaxed);
+        }
+
+        void add(uint8_t byte, uintptr_t child) override {
+            int slot = 0;
+            while (children[slot].load(std::memory_order_relaxed) != 0) ++slot;
+            children[slot].store(child, std::memory_order_relaxed);
+            index[byte].store(slot, std::memory_order_relaxed);
+            this->count.store(this->count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        void change(uint8_t byte, uintptr_t child) override {
+            children[index[byte].load(std::memory_order_relaxed)].store(child, std::memory_order_relaxed);
+        }
+
+        void erase(uint8_t byte) override {
+            uint8_t i = index[byte].load(std::memory_order_relaxed);
+            if (i == kEmpty) return;
+            children[i].store(0, std::memory_order_relaxed);
+            index[byte].store(kEmpty, std::memory_order_relaxed);
+            this->count.store(this->count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
+
+        bool full() const override { return this->count.load(std::memory_order_relaxed) == 48; }
+        bool underfull() const override { return this->count.load(std::memory_order_relaxed) <= 12; }
+
+        Node* grow() const override { return copyTo(new Node256()); }
+        Node* shrink() const override { return copyTo(new Node16()); }
+
+        uintptr_t first(uint8_t& byte) const override {
+            for (int b = 0; b < 256; ++b) {
+                if (index[b].load(std::memory_order_relaxed) != kEmpty) {
+                    byte = b;
+                    return get(b);
+                }
+            }
+            return 0;
+        }
+
+        Node* copyTo(Node* to) const {
+            to->prefixLength.store(this->prefixLength.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            to->prefix.store(this->prefix.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            for (int b = 0; b < 256; ++b) {
+                if (uintptr_t child = get(b)) to->add(b, child);
+            }
+            return to;
+        }
+    };
+
+    struct Node256 : Node {
+        Slot children[256];
+
+        Node256() {
+            for (auto& c : children) c.store(0, std::memory_order_relaxed);
+        }
+
+        uintptr_t get(uint8_t byte) const override { return children[byte].load(std::memory_order_relaxed); }
+
+        void add(uint8_t byte, uintptr_t child) override {
+            children[byte].store(child, std::memory_order_relaxed);
+            this->count.store(this->count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        void change(uint8_t byte, uintptr_t child) override { children[byte].store(child, std::memory_order_relaxed); }
+
+        void erase(uint8_t byte) override {
+            if (!children[byte].load(std::memory_order_relaxed)) return;
+            children[byte].store(0, std::memory_order_relaxed);
+            this->count.store(this->count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
+
+        bool full() const override { return false; }
+        bool underfull() const override { return this->count.load(std::memory_order_relaxed) <= 37; }
+        Node* grow() const override { return nullptr; }
+
+        Node* shrink() const override {
+            Node* small = new Node48();
+            small->prefixLength.store(this->prefixLength.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            small->prefix.store(this->prefix.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            for (int b = 0; b < 256; ++b) {
+                if (uintptr_t child = get(b)) small->add(b, child);
+            }
+            return small;
+        }
+
+        uintptr_t first(uint8_t& byte) const override {
+            for (int b = 0; b < 256; ++b) {
+                if (uintptr_t child = get(b)) {
+                    byte = b;
+                    return child;
+                }
+            }
+            return 0;
+        }
+    };
+
+    Reclaimer& reclaimer;
+    Node* const root; // A Node256 with no prefix; never replaced
+
+    static uint32_t bits(int key) { return static_cast<uint32_t>(key) ^ 0x80000000u; }
+    static uint8_t keyByte(uint32_t key, int depth) { return key >> (24 - 8 * depth); }
+    static uint8_t prefixByte(uint32_t prefix, int i) { return prefix >> (24 - 8 * i); }
+
+    // Bytes [from, from + length) of key, packed as a prefix
+    static uint32_t slice(uint32_t key, int from, int length) {
+        return length == 0 ? 0 : (key << (8 * from)) & ~(0xFFFFFFFFu >> (8 * length));
+    }
+
+    static bool isLeaf(uintptr_t child) { return child & kLeaf; }
+    static uintptr_t leaf(uint32_t key) { return (static_cast<uintptr_t>(key) << 1) | kLeaf; }
+    static uint32_t leafKey(uintptr_t child) { return static_cast<uint32_t>(child >> 1); }
+    static uintptr_t link(Node* node) { return reinterpret_cast<uintptr_t>(node); }
+    static Node* address(uintptr_t child) { return reinterpret_cast<Node*>(child); }
+
+    static bool readLock(Node* node, uint64_t& version) {
+        version = node->version.load(std::memory_order_acquire);
+        return !(version & (kLocked | kObsolete));
+    }
+
+    // Did nothing change since readLock returned version?
+    static bool validate(Node* node, uint64_t version) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return node->version.load(std::memory_order_relaxed) == version;
+    }
+
+    static bool upgrade(Node* node, uint64_t version) {
+        if (!node->version.compare_exchange_strong(version, version + kLocked, std::memory_order_acquire)) {
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_release); // Our writes stay after the lock
+        return true;
+    }
+
+    static void writeUnlock(Node* node) { node->version.fetch_add(kLocked, std::memory_order_release); }
+    static void writeUnlockObsolete(Node* node) { node->version.fetch_add(kLocked + kObsolete, std::memory_order_release); }
+
+    // Index of the first prefix byte that differs from key at depth, or the prefix length
+    static int mismatch(Node* node, uint32_t key, int depth) {
+        int length = node->prefixLength.load(std::memory_order_relaxed);
+        uint32_t prefix = node->prefix.load(std::memory_order_relaxed);
+        for (int i = 0; i < length && depth + i < 4; ++i) {
+            if (prefixByte(prefix, i) != keyByte(key, depth + i)) return i;
+        }
+        return length;
+    }
+
+    bool lookup(uint32_t key) {
+    restart:
+        Node* node = root;
+        uint64_t v;
+        if (!readLock(node, v)) goto restart;
+        for (int depth = 0;; ++depth) {
+            int length = node->prefixLength.load(std::memory_order_relaxed);
+            if (mismatch(node, key, depth) != length) {
+                if (!validate(node, v)) goto restart;
+                return false;
+            }
+            depth += length;
+            uintptr_t child = node->get(keyByte(key, depth));
+            if (!validate(node, v)) goto restart;
+            if (!child) return false;
+            if (isLeaf(child)) return leafKey(child) == key;
+            Node* next = address(child);
+            uint64_t nv;
+            if (!readLock(next, nv) || !validate(node, v)) goto restart;
+            node = next;
+            v = nv;
+        }
+    }
+
+    bool insertKey(uint32_t key, int tid) {
+    restart:
+        Node* parent = nullptr;
+        uint64_t pv = 0;
+        uint8_t parentByte = 0;
+        Node* node = root;
+        uint64_t v;
+        if (!readLock(node, v)) goto restart;
+        for (int depth = 0;; ++depth) {
+            int length = node->prefixLength.load(std::memory_order_relaxed);
+            uint32_t prefix = node->prefix.load(std::memory_order_relaxed);
+            int at = mismatch(node, key, depth);
+            if (at != length) {
+                // Split the compressed path: a new Node4 takes over the common part
+                if (!upgrade(parent, pv)) goto restart;
+                if (!upgrade(node, v)) {
+                    writeUnlock(parent);
+                    goto restart;
+                }
+                Node* split = new Node4();
+                split->prefixLength.store(at, std::memory_order_relaxed);
+                split->prefix.store(slice(prefix, 0, at), std::memory_order_relaxed);
+                split->add(keyByte(key, depth + at), leaf(key));
+                split->add(prefixByte(prefix, at), link(node));
+                node->prefixLength.store(length - at - 1, std::memory_order_relaxed);
+                node->prefix.store(slice(prefix, at + 1, length - at - 1), std::memory_order_relaxed);
+                parent->change(parentByte, link(split));
+                writeUnlock(node);
+                writeUnlock(parent);
+                return true;
+            }
+            depth += length;
+            uint8_t byte = keyByte(key, depth);
+            uintptr_t child = node->get(byte);
+            if (!validate(node, v)) goto restart;
+            if (!child) {
+                if (node->full()) {
+                    // Only inner nodes fill up, and those have a parent
+                    if (!upgrade(parent, pv)) goto restart;
+                    if (!upgrade(node, v)) {
+                        writeUnlock(parent);
+                        goto restart;
+                    }
+                    Node* big = node->grow();
+                    big->add(byte, leaf(key));
+                    parent->change(parentByte, link(big));
+                    writeUnlock(parent);
+                    writeUnlockObsolete(node);
+                    reclaimer.retire(node, tid);
+                } else {
+                    if (!upgrade(node, v)) goto restart;
+                    if (parent && !validate(parent, pv)) {
+                        writeUnlock(node);
+                        goto restart;
+                    }
+                    node->add(byte, leaf(key));
+                    writeUnlock(node);
+                }
+                return true;
+            }
+            if (parent && !validate(parent, pv)) goto restart;
+            if (isLeaf(child)) {
+                if (!upgrade(node, v)) goto restart;
+                uint32_t other = leafKey(child);
+                if (other == key) {
+                    writeUnlock(node);
+                    return false;
+                }
+                // Lazy expansion: push both leaves one level down, below their common bytes
+                int from = depth + 1;
+                int common = 0;
+                while (keyByte(key, from + common) == keyByte(other, from + common)) ++common;
+                Node* pair = new Node4();
+                pair->prefixLength.store(common, std::memory_order_relaxed);
+                pair->prefix.store(slice(key, from, common), std::memory_order_relaxed);
+                pair->add(keyByte(key, from + common), leaf(key));
+                pair->add(keyByte(other, from + common), child);
+                node->change(byte, link(pair));
+                writeUnlock(node);
+                return true;
+            }
+            parent = node;
+            pv = v;
+            parentByte = byte;
+            node = address(child);
+            if (!readLock(node, v)) goto restart;
+        }
+    }
+
+    bool removeKey(uint32_t key, int tid) {
+    restart:
+        Node* parent = nullptr;
+        uint64_t pv = 0;
+        uint8_t parentByte = 0;
+        Node* node = root;
+        uint64_t v;
+        if (!readLock(node, v)) goto restart;
+        for (int depth = 0;; ++depth) {
+            int length = node->prefixLength.load(std::memory_order_relaxed);
+            if (mismatch(node, key, depth) != length) {
+                if (!validate(node, v)) goto restart;
+                return false;
+            }
+            depth += length;
+            uint8_t byte = keyByte(key, depth);
+            uintptr_t child = node->get(byte);
+            if (!validate(node, v)) goto restart;
+            if (!child) return false;
+            if (isLeaf(child)) {
+                if (leafKey(child) != key) return false;
+                int count = node->count.load(std::memory_order_relaxed);
+                if (parent && (count == 2 || node->underfull())) {
+                    if (!upgrade(parent, pv)) goto restart;
+                    if (!upgrade(node, v)) {
+                        writeUnlock(parent);
+                        goto restart;
+                    }
+                    node->erase(byte);
+                    if (count == 2) {
+                        if (!merge(node, parent, parentByte)) {
+                            node->add(byte, child); // The child was busy; put things back
+                            writeUnlock(node);
+                            writeUnlock(parent);
+                            goto restart;
+                        }
+                    } else {
+                        parent->change(parentByte, link(node->shrink()));
+                    }
+                    writeUnlock(parent);
+                    writeUnlockObsolete(node);
+                    reclaimer.retire(node, tid);
+                } else {
+                    if (!upgrade(node, v)) goto restart;
+                    if (parent && !validate(parent, pv)) {
+                        writeUnlock(node);
+                        goto restart;
+                    }
+                    node->erase(byte);
+                    writeUnlock(node);
+                }
+                return true;
+            }
+            if (parent && !validate(parent, pv)) goto restart;
+            parent = node;
+            pv = v;
+            parentByte = byte;
+            node = address(child);
+            if (!readLock(node, v)) goto restart;
+        }
+    }
+
+    // Replace a locked node with its one remaining child, folding node's
+    // prefix and branch byte into the child's prefix
+    bool merge(Node* node, Node* parent, uint8_t parentByte) {
+        uint8_t byte;
+        uintptr_t child = node->first(byte);
+        if (!isLeaf(child)) {
+            Node* next = address(child);
+            uint64_t nv;
+            if (!readLock(next, nv) || !upgrade(next, nv)) return false;
+            int length = node->prefixLength.load(std::memory_order_relaxed);
+            int childLength = next->prefixLength.load(std::memory_order_relaxed);
+            uint32_t prefix = node->prefix.load(std::memory_order_relaxed) |
+                              (static_cast<uint32_t>(byte) << (24 - 8 * length)) |
+                              (next->prefix.load(std::memory_order_relaxed) >> (8 * (length + 1)));
+            next->prefixLength.store(length + 1 + childLength, std::memory_order_relaxed);
+            next->prefix.store(prefix, std::memory_order_relaxed);
+            writeUnlock(next);
+        }
+        parent->change(parentByte, child);
+        return true;
+    }
+
+    void deleteTree(Node* node) {
+        for (int b = 0; b < 256; ++b) {
+            uintptr_t child = node->get(b);
+            if (child && !isLeaf(child)) deleteTree(address(child));
+        }
+        delete node;
+    }
+};
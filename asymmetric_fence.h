@@ -0,0 +1,35 @@
+#pragma once
+
+#include <atomic>
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Asymmetric fences: the frequent side (readers publishing a reservation)
+// only keeps the compiler from reordering, and the rare side (a reclaimer
+// about to scan) uses membarrier to force a full barrier on every running
+// thread of the process.
+namespace asymmetric_fence {
+
+// Registers the process for private expedited membarrier; false if the
+// kernel does not support it, in which case callers must stay fenced.
+inline bool init() {
+    static const bool supported = [] {
+        long commands = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+        if (commands < 0 || !(commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED)) return false;
+        return syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+    }();
+    return supported;
+}
+
+// Reader side
+inline void light() {
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+// Reclaimer side
+inline void heavy() {
+    syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+}
+
+} // namespace asymmetric_fence
@@ -0,0 +1,12 @@
+#include "chromatic_tree.h"
+#include "set_bench.h"
+
+// Chromatic tree under each reclamation scheme. Besides removed nodes, every
+// update retires the SCX records it used, so it retires several objects per
+// operation where the Natarajan-Mittal BST retires at most two.
+int main(int argc, char* argv[]) {
+    SetWorkload workload = parseSetWorkload(argc, argv);
+    runSetWorkload<ChromaticTree, HyalineReclaimer>(workload);
+    runSetWorkload<ChromaticTree, IBRReclaimer>(workload);
+    return 0;
+}
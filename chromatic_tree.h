@@ -0,0 +1,428 @@
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+// Brown's lock-free chromatic tree (PPoPP 2014): a leaf-oriented BST with
+// relaxed red-black balance. Every node has a weight (0 = red, 1 = black,
+// more = overweight), and all root-to-leaf paths have the same total weight.
+// Updates may leave a red-red or overweight violation behind; the updater
+// then repairs violations on its own search path with local rotations and
+// recolourings, each applied atomically.
+//
+// Every change goes through LLX/SCX (Brown, Ellen, Ruppert, PODC 2013): LLX
+// snapshots a node's children, and SCX replaces one child pointer provided
+// none of the snapshotted nodes changed, finalizing the nodes it removes. A
+// node is frozen for an SCX by pointing its info word at the SCX record, and
+// anyone who finds a frozen node helps that SCX finish.
+//
+// Records are reclaimed too. Each counts the nodes whose info word points
+// at it, plus one for its creator, and is retired when that reaches zero.
+// Info words carry a 16-bit tag bumped on every change, so a freeze CAS
+// cannot succeed against a recycled record address. Keys must be below
+// INT_MAX (the sentinel).
+template <class Reclaimer>
+class ChromaticTree {
+public:
+    explicit ChromaticTree(Reclaimer& reclaimer)
+        : reclaimer(reclaimer), entry(new Node(kInf, 1, new Node(kInf, 1), nullptr)) {}
+
+    ~ChromaticTree() {
+        std::unordered_set<Scx*> records; // Left on nodes by helpers of aborted SCXs
+        std::vector<Node*> stack{entry};
+        while (!stack.empty()) {
+            Node* node = stack.back();
+            stack.pop_back();
+            if (Scx* rec = record(node->info.load())) records.insert(rec);
+            if (Node* left = node->left.load()) stack.push_back(left);
+            if (Node* right = node->right.load()) stack.push_back(right);
+            delete node;
+        }
+        for (Scx* rec : records) delete rec;
+    }
+
+    bool insert(int key, int tid) {
+        reclaimer.enter(tid);
+        bool inserted;
+        bool violation = false;
+        while (true) {
+            Node* p = entry;
+            Node* l = entry->left.load(std::memory_order_acquire);
+            while (!isLeaf(l)) {
+                p = l;
+                l = child(l, key);
+            }
+            if (l->key == key) {
+                inserted = false;
+                break;
+            }
+            Linked lp, ll;
+            if (!llx(p, lp, tid) || !field(lp, l) || !llx(l, ll, tid)) continue;
+            Fresh fresh;
+            int weight = p == entry ? 1 : l->weight - 1;
+            Node* leaf = fresh(new Node(key, 1));
+            Node* sibling = fresh(new Node(l->key, 1));
+            Node* n = fresh(key < l->key ? new Node(l->key, weight, leaf, sibling)
+                                         : new Node(key, weight, sibling, leaf));
+            Linked v[] = {lp, ll};
+            if (scx(v, 2, 0b10, field(lp, l), l, n, tid)) {
+                inserted = true;
+                violation = weight == 0 ? p->weight == 0 : weight > 1;
+                break;
+            }
+            fresh.discard();
+        }
+        if (violation) cleanup(key, tid);
+        reclaimer.leave(tid);
+        return inserted;
+    }
+
+    bool remove(int key, int tid) {
+        reclaimer.enter(tid);
+        bool removed;
+        bool violation = false;
+        while (true) {
+            Node* gp = nullptr;
+            Node* p = entry;
+            Node* l = entry->left.load(std::memory_order_acquire);
+            while (!isLeaf(l)) {
+                gp = p;
+                p = l;
+                l = child(l, key);
+            }
+            if (l->key != key) {
+                removed = false;
+                break;
+            }
+            // A real key's leaf always has an internal parent below entry
+            Linked lgp, lp, ll, ls;
+            if (!llx(gp, lgp, tid) || !field(lgp, p) || !llx(p, lp, tid) || !field(lp, l)) continue;
+            Node* s = lp.left == l ? lp.right : lp.left;
+            if (!llx(l, ll, tid) || !llx(s, ls, tid)) continue;
+            int weight = gp == entry ? 1 : p->weight + s->weight;
+            Node* n = new Node(s->key, weight, ls.left, ls.right);
+            Linked v[] = {lgp, lp, ll, ls};
+            if (scx(v, 4, 0b1110, field(lgp, p), p, n, tid)) {
+                removed = true;
+                violation = weight > 1;
+                break;
+            }
+            delete n; // Never published
+        }
+        if (violation) cleanup(key, tid);
+        reclaimer.leave(tid);
+        return removed;
+    }
+
+    bool contains(int key, int tid) {
+        reclaimer.enter(tid);
+        Node* l = entry->left.load(std::memory_order_acquire);
+        while (!isLeaf(l)) l = child(l, key);
+        bool found = l->key == key;
+        reclaimer.leave(tid);
+        return found;
+    }
+
+private:
+    static constexpr int kInf = INT_MAX;
+    static constexpr int kMaxV = 5; // Most nodes any one SCX depends on
+    static constexpr uint64_t kPtrMask = (1ULL << 48) - 1;
+    static constexpr uint64_t kTagOne = 1ULL << 48;
+    enum { kInProgress, kCommitted, kAborted };
+
+    struct Scx;
+
+    struct Node : Reclaimer::Node {
+        const int key;
+        const int weight;
+        std::atomic<Node*> left;  // Both null for a leaf
+        std::atomic<Node*> right;
+        std::atomic<uint64_t> info{0}; // Scx* | tag << 48; null when not frozen
+        std::atomic<bool> marked{false}; // Finalized: removed by a committed SCX
+
+        Node(int k, int w, Node* l = nullptr, Node* r = nullptr) : key(k), weight(w), left(l), right(r) {}
+    };
+
+    struct Scx : Reclaimer::Node {
+        int size;
+        Node* nodes[kMaxV];    // Top-down, so competing SCXs freeze in the same order
+        uint64_t seen[kMaxV];  // Info word of each node at its LLX
+        unsigned finalize;     // Bit i: nodes[i] is removed
+        std::atomic<Node*>* field;
+        Node* old;
+        Node* replacement;
+        std::atomic<int> state{kInProgress};
+        std::atomic<bool> allFrozen{false};
+        std::atomic<int> refs{1}; // Creator, plus each node frozen for this SCX
+    };
+
+    struct Linked {
+        Node* node;
+        uint64_t info;
+        Node* left;
+        Node* right;
+    };
+
+    // New nodes of one attempt, deleted if its SCX fails
+    struct Fresh {
+        Node* nodes[4];
+        int count = 0;
+
+        Node* operator()(Node* node) { return nodes[count++] = node; }
+        void discard() {
+            for (int i = 0; i < count; ++i) delete nodes[i];
+        }
+    };
+
+    Reclaimer& reclaimer;
+    Node* const entry; // Sentinel above the root; every key goes left
+
+    static bool isLeaf(Node* node) { return node->left.load(std::memory_order_acquire) == nullptr; }
+    static Node* child(Node* node, int key) {
+        return key < node->key ? node->left.load(std::memory_order_acquire)
+                               : node->right.load(std::memory_order_acquire);
+    }
+    static std::atomic<Node*>* field(const Linked& parent, Node* node) {
+        if (parent.left == node) return &parent.node->left;
+        if (parent.right == node) return &parent.node->right;
+        return nullptr;
+    }
+
+    static Scx* record(uint64_t info) { return reinterpret_cast<Scx*>(info & kPtrMask); }
+    static uint64_t frozenFor(Scx* rec, uint64_t seen) {
+        return reinterpret_cast<uint64_t>(rec) | ((seen & ~kPtrMask) + kTagOne);
+    }
+
+    // Take a reference unless the record is already done with
+    static bool acquire(Scx* rec) {
+        int refs = rec->refs.load();
+        while (refs > 0) {
+            if (rec->refs.compare_exchange_weak(refs, refs + 1)) return true;
+        }
+        return false;
+    }
+
+    void release(Scx* rec, int tid) {
+        if (rec->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) reclaimer.retire(rec, tid);
+    }
+
+    // Point node i's info word back at nothing, if it is still frozen for rec
+    void unfreeze(Scx* rec, int i, int tid) {
+        uint64_t frozen = frozenFor(rec, rec->seen[i]);
+        if (rec->nodes[i]->info.compare_exchange_strong(frozen, (frozen & ~kPtrMask) + kTagOne)) {
+            release(rec, tid);
+        }
+    }
+
+    // A snapshot of node's children that an SCX can later depend on. Fails
+    // if node is frozen for an SCX in progress (after helping it) or removed.
+    bool llx(Node* node, Linked& out, int tid) {
+        uint64_t info = node->info.load(std::memory_order_acquire);
+        Scx* rec = record(info);
+        int state = rec ? rec->state.load(std::memory_order_acquire) : kCommitted;
+        bool marked = node->marked.load(std::memory_order_acquire);
+        if (state == kAborted || (state == kCommitted && !marked)) {
+            out.left = node->left.load(std::memory_order_acquire);
+            out.right = node->right.load(std::memory_order_acquire);
+            if (node->info.load(std::memory_order_acquire) == info) {
+                out.node = node;
+                out.info = info;
+                return true;
+            }
+        }
+        if (state == kInProgress) help(rec, tid);
+        return false;
+    }
+
+    // Freeze every node, then finalize and swing the field. Anyone may run this.
+    bool help(Scx* rec, int tid) {
+        for (int i = 0; i < rec->size; ++i) {
+            Node* node = rec->nodes[i];
+            if (record(node->info.load(std::memory_order_acquire)) == rec) continue;
+            if (!acquire(rec)) return rec->state.load() == kCommitted; // Creator has finished
+            uint64_t expected = rec->seen[i];
+            if (node->info.compare_exchange_strong(expected, frozenFor(rec, rec->seen[i]))) {
+                if (Scx* prev = record(rec->seen[i])) release(prev, tid);
+                // A helper running late can freeze a node of an SCX that has already aborted
+                if (rec->state.load() != kInProgress) unfreeze(rec, i, tid);
+                continue;
+            }
+            release(rec, tid);
+            if (record(expected) != rec) {
+                if (rec->allFrozen.load()) return true;
+                rec->state.store(kAborted);
+                return false;
+            }
+        }
+        rec->allFrozen.store(true);
+        for (int i = 0; i < rec->size; ++i) {
+            if (rec->finalize & (1u << i)) rec->nodes[i]->marked.store(true);
+        }
+        Node* old = rec->old;
+        rec->field->compare_exchange_strong(old, rec->replacement);
+        rec->state.store(kCommitted);
+        return true;
+    }
+
+    // Replace old with replacement in field, provided none of v changed since
+    // its LLX. On success the finalized nodes are retired.
+    bool scx(const Linked* v, int size, unsigned finalize, std::atomic<Node*>* field, Node* old,
+             Node* replacement, int tid) {
+        Scx* rec = new Scx();
+        rec->size = size;
+        for (int i = 0; i < size; ++i) {
+            rec->nodes[i] = v[i].node;
+            rec->seen[i] = v[i].info;
+        }
+        rec->finalize = finalize;
+        rec->field = field;
+        rec->old = old;
+        rec->replacement = replacement;
+        bool committed = help(rec, tid);
+        for (int i = 0; i < size; ++i) unfreeze(rec, i, tid);
+        if (committed) {
+            for (int i = 0; i < size; ++i) {
+                if (finalize & (1u << i)) reclaimer.retire(v[i].node, tid);
+            }
+        }
+        release(rec, tid);
+        return committed;
+    }
+
+    // Repair violations on the search path for key, highest first, until none is left
+    void cleanup(int key, int tid) {
+        while (true) {
+            Node* gg = nullptr;
+            Node* g = nullptr;
+            Node* p = entry;
+            Node* v = entry->left.load(std::memory_order_acquire);
+            while (true) {
+                bool violation = p == entry ? v->weight != 1
+                                            : v->weight > 1 || (v->weight == 0 && p->weight == 0);
+                if (violation) break;
+                if (isLeaf(v)) return;
+                gg = g;
+                g = p;
+                p = v;
+                v = child(v, key);
+            }
+            if (p == entry) {
+                fixRoot(v, tid);
+            } else if (v->weight == 0) {
+                fixRedRed(gg, g, p, v, tid); // The root is black, so p has a parent g
+            } else {
+                fixOverweight(g, p, v, tid);
+            }
+        }
+    }
+
+    // The root's weight is on every path, so it can always be reset to 1
+    void fixRoot(Node* root, int tid) {
+        Linked le, lr;
+        if (!llx(entry, le, tid) || le.left != root || !llx(root, lr, tid)) return;
+        Node* n = new Node(root->key, 1, lr.left, lr.right);
+        Linked v[] = {le, lr};
+        if (!scx(v, 2, 0b10, &entry->left, root, n, tid)) delete n;
+    }
+
+    // v and its parent p are both red
+    void fixRedRed(Node* gg, Node* g, Node* p, Node* v, int tid) {
+        Linked lgg, lg, lp;
+        if (!llx(gg, lgg, tid) || !field(lgg, g) || !llx(g, lg, tid) || !field(lg, p) || !llx(p, lp, tid) ||
+            !field(lp, v)) {
+            return;
+        }
+        bool pLeft = lg.left == p;
+        Node* q = pLeft ? lg.right : lg.left;
+        Fresh fresh;
+        Node* n;
+        bool committed;
+        if (q->weight == 0) {
+            // BLK: both children of g red; push g's blackness down to them
+            Linked lq;
+            if (g->weight == 0 || !llx(q, lq, tid)) return;
+            Node* np = fresh(new Node(p->key, 1, lp.left, lp.right));
+            Node* nq = fresh(new Node(q->key, 1, lq.left, lq.right));
+            int weight = gg == entry ? 1 : g->weight - 1;
+            n = fresh(pLeft ? new Node(g->key, weight, np, nq) : new Node(g->key, weight, nq, np));
+            Linked v4[] = {lgg, lg, lp, lq};
+            committed = scx(v4, 4, 0b1110, field(lgg, g), g, n, tid);
+        } else if (pLeft == (lp.left == v)) {
+            // RB1: v is an outer grandchild; single rotation at g
+            if (pLeft) {
+                Node* ng = fresh(new Node(g->key, 0, lp.right, q));
+                n = fresh(new Node(p->key, g->weight, v, ng));
+            } else {
+                Node* ng = fresh(new Node(g->key, 0, q, lp.left));
+                n = fresh(new Node(p->key, g->weight, ng, v));
+            }
+            Linked v3[] = {lgg, lg, lp};
+            committed = scx(v3, 3, 0b110, field(lgg, g), g, n, tid);
+        } else {
+            // RB2: v is an inner grandchild; double rotation brings it to the top
+            Linked lv;
+            if (!llx(v, lv, tid)) return;
+            Node* left;
+            Node* right;
+            if (pLeft) {
+                left = fresh(new Node(p->key, 0, lp.left, lv.left));
+                right = fresh(new Node(g->key, 0, lv.right, q));
+            } else {
+                left = fresh(new Node(g->key, 0, q, lv.left));
+                right = fresh(new Node(p->key, 0, lv.right, lp.right));
+            }
+            n = fresh(new Node(v->key, g->weight, left, right));
+            Linked v4[] = {lgg, lg, lp, lv};
+            committed = scx(v4, 4, 0b1110, field(lgg, g), g, n, tid);
+        }
+        if (!committed) fresh.discard();
+    }
+
+    // v weighs more than 1
+    void fixOverweight(Node* g, Node* p, Node* v, int tid) {
+        Linked lg, lp, lv, ls;
+        if (!llx(g, lg, tid) || !field(lg, p) || !llx(p, lp, tid) || !field(lp, v)) return;
+        bool vLeft = lp.left == v;
+        Node* s = vLeft ? lp.right : lp.left;
+        if (!llx(v, lv, tid) || !llx(s, ls, tid)) return;
+        Fresh fresh;
+        bool committed;
+        // Equal path weights mean any leaf among s and its children weighs at
+        // least v->weight, so the decrements below never leave a red leaf
+        if (s->weight > 0) {
+            // PUSH: move one unit of weight from v and its sibling up to p
+            Node* nv = fresh(new Node(v->key, v->weight - 1, lv.left, lv.right));
+            Node* ns = fresh(new Node(s->key, s->weight - 1, ls.left, ls.right));
+            int weight = g == entry ? 1 : p->weight + 1;
+            Node* n = fresh(vLeft ? new Node(p->key, weight, nv, ns) : new Node(p->key, weight, ns, nv));
+            Linked v4[] = {lg, lp, lv, ls};
+            committed = scx(v4, 4, 0b1110, field(lg, p), p, n, tid);
+        } else {
+            // Red sibling: rotate it above p, then push into v and its new sibling
+            Node* inner = vLeft ? ls.left : ls.right;
+            if (!inner) return; // Stale snapshot: a red node is never a leaf
+            if (inner->weight == 0) {
+                fixRedRed(g, p, s, inner, tid); // Clear the red-red below s first
+                return;
+            }
+            Linked li;
+            if (!llx(inner, li, tid)) return;
+            Node* nv = fresh(new Node(v->key, v->weight - 1, lv.left, lv.right));
+            Node* ni = fresh(new Node(inner->key, inner->weight - 1, li.left, li.right));
+            Node* n;
+            if (vLeft) {
+                Node* m = fresh(new Node(p->key, 1, nv, ni));
+                n = fresh(new Node(s->key, p->weight, m, ls.right));
+            } else {
+                Node* m = fresh(new Node(p->key, 1, ni, nv));
+                n = fresh(new Node(s->key, p->weight, ls.left, m));
+            }
+            Linked v5[] = {lg, lp, lv, ls, li};
+            committed = scx(v5, 5, 0b11110, field(lg, p), p, n, tid);
+        }
+        if (!committed) fresh.discard();
+    }
+};
@@ -0,0 +1,83 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "ctrie.h"
+#include "set_bench.h"
+
+// Ctrie under each reclamation scheme. With "snapshots" as the last argument,
+// one extra thread keeps taking a snapshot, counting its keys and releasing
+// it while the workload runs, so superseded nodes pile up until the snapshot
+// that may still reach them is given back.
+template <class Reclaimer>
+void runWithExporter(const SetWorkload& w) {
+    Reclaimer reclaimer(w.threads + 1);
+    double throughput;
+    long exported = 0, keys = 0;
+    {
+        Ctrie<Reclaimer> set(reclaimer);
+        std::mt19937 prefill(0);
+        for (int i = 0; i < w.keyRange / 2; ++i) {
+            set.insert(prefill() % w.keyRange, 0);
+        }
+
+        std::atomic<bool> done{false};
+        std::thread exporter([&]() {
+            int tid = w.threads;
+            while (!done.load(std::memory_order_relaxed)) {
+                auto snapshot = set.snapshot(tid);
+                set.forEach(snapshot, [&keys](int) { ++keys; }, tid);
+                set.release(snapshot, tid);
+                ++exported;
+            }
+        });
+
+        std::vector<std::thread> workers;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (int t = 0; t < w.threads; ++t) {
+            workers.emplace_back([&set, &w, t]() {
+                std::mt19937 gen(t + 1);
+                for (int j = 0; j < w.opsPerThread; ++j) {
+                    int key = gen() % w.keyRange;
+                    int dice = gen() % 100;
+                    if (dice < w.updatePercent / 2) {
+                        set.insert(key, t);
+                    } else if (dice < w.updatePercent) {
+                        set.remove(key, t);
+                    } else {
+                        set.contains(key, t);
+                    }
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        auto end_time = std::chrono::high_resolution_clock::now();
+        done.store(true);
+        exporter.join();
+        std::chrono::duration<double> elapsed = end_time - start_time;
+        throughput = static_cast<double>(w.threads) * w.opsPerThread / elapsed.count();
+        std::cout << Reclaimer::name() << " | Snapshots: " << exported / elapsed.count() << " /sec | Keys per snapshot: "
+                  << (exported ? keys / exported : 0) << std::endl;
+    }
+    std::cout << Reclaimer::name() << " | Threads: " << w.threads << " | Throughput: " << throughput
+              << " ops/sec" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    bool snapshots = argc >= 2 && std::strcmp(argv[argc - 1], "snapshots") == 0;
+    SetWorkload workload = parseSetWorkload(snapshots ? argc - 1 : argc, argv);
+    if (snapshots) {
+        runWithExporter<HyalineReclaimer>(workload);
+        runWithExporter<IBRReclaimer>(workload);
+    } else {
+        runSetWorkload<Ctrie, HyalineReclaimer>(workload);
+        runSetWorkload<Ctrie, IBRReclaimer>(workload);
+    }
+    return 0;
+}
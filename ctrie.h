@@ -0,0 +1,561 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Concurrent hash trie (Prokopec, Bronson, Bagwell and Odersky, PPoPP 2012)
+// over int keys, with lock-free insert, remove and contains and O(1)
+// read-only snapshots.
+//
+// Each level consumes 5 bits of the key. An I-node points to a main node,
+// either a C-node (bitmap plus branches) or a T-node (a tombed key waiting
+// to be merged into its parent). Updates copy a C-node and swing the I-node
+// with GCAS, which only commits while the root still has the I-node's
+// generation. A snapshot swaps in a root of a new generation with RDCSS, so
+// pending GCASes under the old root fail, and later writers copy any shared
+// C-node and I-node (renew) before changing it. The key is its own 32-bit
+// hash, so two keys always part by the last level and no collision lists
+// are needed.
+//
+// A node unlinked by the generation it was created in can be reached by
+// nothing but in-flight operations, and is retired right away. An older
+// node may still be part of a snapshot. It is parked until no snapshot is
+// outstanding and then retired.
+template <class Reclaimer>
+class Ctrie {
+public:
+    // A read-only view of the set as of snapshot(); give it back with release()
+    struct Snapshot {
+        void* root = nullptr;
+    };
+
+    explicit Ctrie(Reclaimer& reclaimer) : reclaimer(reclaimer) {
+        uint64_t gen = nextGen.fetch_add(1);
+        root.store(new INode(new CNode(0, 0, gen), gen));
+    }
+
+    ~Ctrie() {
+        freeTree(static_cast<INode*>(root.load()));
+        for (Node* node : deferred) delete node;
+    }
+
+    bool insert(int key, int tid) {
+        reclaimer.enter(tid);
+        SNode* sn = new SNode(key, readRoot(false)->gen);
+        Result res;
+        while ((res = insertAt(readRoot(false), sn, tid)) == kRestart) {
+        }
+        if (res != kDone) reclaimer.retire(sn, tid); // Never linked, but failed attempts may have shown it
+        reclaimer.leave(tid);
+        return res == kDone;
+    }
+
+    bool remove(int key, int tid) {
+        reclaimer.enter(tid);
+        Result res;
+        while ((res = removeAt(readRoot(false), key, tid)) == kRestart) {
+        }
+        reclaimer.leave(tid);
+        return res == kDone;
+    }
+
+    bool contains(int key, int tid) {
+        reclaimer.enter(tid);
+        bool found = lookup(readRoot(false), key, false);
+        reclaimer.leave(tid);
+        return found;
+    }
+
+    Snapshot snapshot(int tid) {
+        snapshots.fetch_add(1); // Before the root moves: see dispose
+        reclaimer.enter(tid);
+        while (true) {
+            INode* r = readRoot(false);
+            MainNode* expected = gcasRead(r, false);
+            uint64_t gen = nextGen.fetch_add(2);
+            INode* live = new INode(expected, gen);
+            INode* frozen = new INode(expected, gen + 1);
+            Descriptor* d = new Descriptor(r, expected, live);
+            Node* current = r;
+            if (!root.compare_exchange_strong(current, d)) {
+                delete d;
+                delete live;
+                delete frozen;
+                continue;
+            }
+            rdcssComplete(d, false);
+            bool committed = d->state.load() == kCommitted;
+            reclaimer.retire(d, tid);
+            if (committed) {
+                reclaimer.retire(r, tid);
+                reclaimer.leave(tid);
+                return Snapshot{frozen};
+            }
+            reclaimer.retire(live, tid); // Helpers may have read it from the descriptor
+            delete frozen;
+        }
+    }
+
+    bool contains(const Snapshot& s, int key, int tid) {
+        reclaimer.enter(tid);
+        bool found = lookup(static_cast<INode*>(s.root), key, true);
+        reclaimer.leave(tid);
+        return found;
+    }
+
+    // Calls visit(key) for every key in the snapshot, in no particular order
+    template <class Callback>
+    void forEach(const Snapshot& s, Callback visit, int tid) {
+        reclaimer.enter(tid);
+        std::vector<INode*> stack{static_cast<INode*>(s.root)};
+        while (!stack.empty()) {
+            INode* in = stack.back();
+            stack.pop_back();
+            MainNode* m = gcasRead(in, true);
+            if (m->kind == kTNode) {
+                visit(static_cast<TNode*>(m)->sn->key);
+                continue;
+            }
+            CNode* cn = static_cast<CNode*>(m);
+            for (int i = 0; i < cn->size; ++i) {
+                Node* branch = cn->array[i];
+                if (branch->kind == kINode) stack.push_back(static_cast<INode*>(branch));
+                else visit(static_cast<SNode*>(branch)->key);
+            }
+        }
+        reclaimer.leave(tid);
+    }
+
+    void release(Snapshot& s, int tid) {
+        reclaimer.enter(tid);
+        reclaimer.retire(static_cast<INode*>(s.root), tid);
+        reclaimer.leave(tid);
+        s.root = nullptr;
+        // Outside the critical section, so a long backlog does not pile up
+        // behind our own reservation
+        if (snapshots.fetch_sub(1) == 1) drain(tid);
+    }
+
+private:
+    static constexpr int kBits = 5;
+
+    enum Kind : uint8_t { kINode, kSNode, kCNode, kTNode, kFailed, kDescriptor };
+    enum Result { kDone, kAbsent, kRestart }; // kAbsent: nothing to do (found for insert, missing for remove)
+    enum State { kPending, kCommitted, kAborted };
+
+    struct Node : Reclaimer::Node {
+        const Kind kind;
+        const uint64_t gen; // Generation it was created in
+
+        Node(Kind k, uint64_t g) : kind(k), gen(g) {}
+    };
+
+    // prev is the main node a pending GCAS replaces, a FailedNode once that
+    // GCAS is doomed, or null once it is decided in our favour
+    struct MainNode : Node {
+        std::atomic<MainNode*> prev{nullptr};
+
+        using Node::Node;
+        ~MainNode() override {
+            MainNode* p = prev.load(std::memory_order_relaxed);
+            if (p && p->kind == kFailed) delete p;
+        }
+    };
+
+    struct FailedNode : MainNode {
+        MainNode* const old; // To be put back
+
+        explicit FailedNode(MainNode* o) : MainNode(kFailed, 0), old(o) {}
+    };
+
+    struct SNode : Node {
+        const int key;
+
+        SNode(int k, uint64_t g) : Node(kSNode, g), key(k) {}
+    };
+
+    struct INode : Node {
+        std::atomic<MainNode*> main;
+
+        INode(MainNode* m, uint64_t g) : Node(kINode, g), main(m) {}
+    };
+
+    // Branches are written before the node is published and never again
+    struct CNode : MainNode {
+        const uint32_t bitmap;
+        const int size;
+        Node** const array; // INode or SNode
+
+        CNode(uint32_t bmp, int n, uint64_t g) : MainNode(kCNode, g), bitmap(bmp), size(n), array(new Node*[n ? n : 1]) {}
+        ~CNode() override { delete[] array; }
+    };
+
+    // Takes over its key's SNode; removing the tomb hands the SNode back
+    struct TNode : MainNode {
+        SNode* const sn;
+
+        TNode(SNode* s, uint64_t g) : MainNode(kTNode, g), sn(s) {}
+    };
+
+    struct Descriptor : Node {
+        INode* const ov;
+        MainNode* const expected;
+        INode* const nv;
+        std::atomic<int> state{kPending};
+
+        Descriptor(INode* o, MainNode* e, INode* n) : Node(kDescriptor, 0), ov(o), expected(e), nv(n) {}
+    };
+
+    Reclaimer& reclaimer;
+    std::atomic<Node*> root; // INode, or a Descriptor while a snapshot swaps it
+    std::atomic<uint64_t> nextGen{1};
+    std::atomic<int> snapshots{0};
+    std::mutex deferredLock;
+    std::vector<Node*> deferred; // Unlinked but possibly still in a snapshot
+
+    static uint32_t flagOf(uint32_t hash, int lev) { return 1u << ((hash >> lev) & 0x1F); }
+    static int posOf(uint32_t bitmap, uint32_t flag) { return __builtin_popcount(bitmap & (flag - 1)); }
+
+    // Generation-compare-and-swap of in's main node from old to n
+    bool gcas(INode* in, MainNode* old, MainNode* n) {
+        n->prev.store(old);
+        MainNode* expected = old;
+        if (!in->main.compare_exchange_strong(expected, n)) {
+            n->prev.store(nullptr); // Never published; old may be freed before n is
+            return false;
+        }
+        gcasComplete(in, n, false);
+        return n->prev.load() == nullptr;
+    }
+
+    MainNode* gcasRead(INode* in, bool readOnly) {
+        MainNode* m = in->main.load();
+        if (!m->prev.load()) return m;
+        return gcasComplete(in, m, readOnly);
+    }
+
+    // Decides a pending GCAS: commit if the root is still in in's generation
+    // (never for a snapshot reader), otherwise mark it failed and put the
+    // old main node back
+    MainNode* gcasComplete(INode* in, MainNode* m, bool readOnly) {
+        while (true) {
+            MainNode* prev = m->prev.load();
+            if (!prev) return m;
+            if (prev->kind == kFailed) {
+                MainNode* old = static_cast<FailedNode*>(prev)->old;
+                MainNode* expected = m;
+                if (in->main.compare_exchange_strong(expected, old)) return old;
+                m = in->main.load();
+                continue;
+            }
+            if (!readOnly && readRoot(true)->gen == in->gen) {
+                if (m->prev.compare_exchange_strong(prev, nullptr)) return m;
+                continue;
+            }
+            FailedNode* fn = new FailedNode(prev);
+            if (!m->prev.compare_exchange_strong(prev, fn)) delete fn;
+            m = in->main.load();
+        }
+    }
+
+    INode* readRoot(bool abort) {
+        while (true) {
+            Node* r = root.load();
+            if (r->kind == kINode) return static_cast<INode*>(r);
+            rdcssComplete(static_cast<Descriptor*>(r), abort);
+        }
+    }
+
+    // Finishes a snapshot's root swap. It goes ahead only if the old root
+    // still has the main node the snapshot shares; operations that meet it
+    // while completing a GCAS abort it instead
+    void rdcssComplete(Descriptor* d, bool abort) {
+        int pending = kPending;
+        if (abort) {
+            d->state.compare_exchange_strong(pending, kAborted);
+        } else if (d->state.load() == kPending) {
+            MainNode* m = gcasRead(d->ov, false);
+            d->state.compare_exchange_strong(pending, m == d->expected ? kCommitted : kAborted);
+        }
+        Node* expected = d;
+        root.compare_exchange_strong(expected, d->state.load() == kCommitted ? static_cast<Node*>(d->nv) : d->ov);
+    }
+
+    // Retires a node just unlinked by a GCAS in generation gen
+    void dispose(Node* node, uint64_t gen, int tid) {
+        if (node->gen == gen) {
+            reclaimer.retire(node, tid);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(deferredLock);
+            deferred.push_back(node);
+        }
+        // A snapshot counts itself before moving the root, so if none is
+        // counted now, none can reach what we just unlinked
+        if (snapshots.load() == 0) drain(tid);
+    }
+
+    void drain(int tid) {
+        std::vector<Node*> nodes;
+        {
+            std::lock_guard<std::mutex> lock(deferredLock);
+            nodes.swap(deferred);
+        }
+        for (Node* node : nodes) reclaimer.retire(node, tid);
+    }
+
+    CNode* insertedAt(CNode* cn, int pos, uint32_t flag, Node* branch, uint64_t gen) {
+        CNode* n = new CNode(cn->bitmap | flag, cn->size + 1, gen);
+        for (int i = 0; i < pos; ++i) n->array[i] = cn->array[i];
+        n->array[pos] = branch;
+        for (int i = pos; i < cn->size; ++i) n->array[i + 1] = cn->array[i];
+        return n;
+    }
+
+    CNode* updatedAt(CNode* cn, int pos, Node* branch, uint64_t gen) {
+        CNode* n = new CNode(cn->bitmap, cn->size, gen);
+        for (int i = 0; i < cn->size; ++i) n->array[i] = cn->array[i];
+        n->array[pos] = branch;
+        return n;
+    }
+
+    CNode* removedAt(CNode* cn, int pos, uint32_t flag, uint64_t gen) {
+        CNode* n = new CNode(cn->bitmap ^ flag, cn->size - 1, gen);
+        for (int i = 0; i < pos; ++i) n->array[i] = cn->array[i];
+        for (int i = pos + 1; i < cn->size; ++i) n->array[i - 1] = cn->array[i];
+        return n;
+    }
+
+    // Below the root, a C-node left with one key becomes a tomb, so the
+    // parent can pull the key up a level
+    MainNode* toContracted(CNode* cn, int lev) {
+        if (lev == 0 || cn->size != 1 || cn->array[0]->kind != kSNode) return cn;
+        TNode* tomb = new TNode(static_cast<SNode*>(cn->array[0]), cn->gen);
+        delete cn; // Never published
+        return tomb;
+    }
+
+    // A C-node holding two keys that share the bits above lev
+    CNode* dual(SNode* x, SNode* y, int lev, uint64_t gen) {
+        uint32_t fx = flagOf(x->key, lev), fy = flagOf(y->key, lev);
+        if (fx == fy) {
+            CNode* n = new CNode(fx, 1, gen);
+            n->array[0] = new INode(dual(x, y, lev + kBits, gen), gen);
+            return n;
+        }
+        CNode* n = new CNode(fx | fy, 2, gen);
+        n->array[fx < fy ? 0 : 1] = x;
+        n->array[fx < fy ? 1 : 0] = y;
+        return n;
+    }
+
+    // Retires the inner nodes of a dual that failed to commit, not its keys
+    void retireDual(CNode* cn, int tid) {
+        for (int i = 0; i < cn->size; ++i) {
+            if (cn->array[i]->kind != kINode) continue;
+            INode* in = static_cast<INode*>(cn->array[i]);
+            retireDual(static_cast<CNode*>(in->main.load()), tid);
+            reclaimer.retire(in, tid);
+        }
+        reclaimer.retire(cn, tid);
+    }
+
+    // Copies a C-node from an older generation, with copies of its I-nodes,
+    // so that the live trie stops sharing it with a snapshot
+    bool renew(INode* in, CNode* cn, int tid) {
+        CNode* n = new CNode(cn->bitmap, cn->size, in->gen);
+        for (int i = 0; i < cn->size; ++i) {
+            Node* branch = cn->array[i];
+            n->array[i] = branch->kind == kINode ? new INode(gcasRead(static_cast<INode*>(branch), false), in->gen) : branch;
+        }
+        bool committed = gcas(in, cn, n);
+        for (int i = 0; i < cn->size; ++i) {
+            if (cn->array[i]->kind != kINode) continue;
+            if (committed) dispose(cn->array[i], in->gen, tid);
+            else reclaimer.retire(n->array[i], tid);
+        }
+        if (committed) dispose(cn, in->gen, tid);
+        else reclaimer.retire(n, tid);
+        return committed;
+    }
+
+    bool lookup(INode* in, int key, bool readOnly) {
+        uint32_t hash = key;
+        for (int lev = 0;; lev += kBits) {
+            MainNode* m = gcasRead(in, readOnly);
+            if (m->kind == kTNode) return static_cast<TNode*>(m)->sn->key == key;
+            CNode* cn = static_cast<CNode*>(m);
+            uint32_t flag = flagOf(hash, lev);
+            if (!(cn->bitmap & flag)) return false;
+            Node* branch = cn->array[posOf(cn->bitmap, flag)];
+            if (branch->kind == kSNode) return static_cast<SNode*>(branch)->key == key;
+            in = static_cast<INode*>(branch);
+        }
+    }
+
+    Result insertAt(INode* in, SNode* sn, int tid) {
+        INode* parent = nullptr;
+        uint32_t hash = sn->key;
+        for (int lev = 0;;) {
+            MainNode* m = gcasRead(in, false);
+            if (m->kind == kTNode) {
+                clean(parent, lev - kBits, tid);
+                return kRestart;
+            }
+            CNode* cn = static_cast<CNode*>(m);
+            if (cn->gen != in->gen) {
+                if (renew(in, cn, tid)) continue;
+                return kRestart;
+            }
+            uint32_t flag = flagOf(hash, lev);
+            int pos = posOf(cn->bitmap, flag);
+            if (!(cn->bitmap & flag)) {
+                CNode* n = insertedAt(cn, pos, flag, sn, in->gen);
+                if (gcas(in, cn, n)) {
+                    dispose(cn, in->gen, tid);
+                    return kDone;
+                }
+                reclaimer.retire(n, tid);
+                return kRestart;
+            }
+            Node* branch = cn->array[pos];
+            if (branch->kind == kINode) {
+                parent = in;
+                in = static_cast<INode*>(branch);
+                lev += kBits;
+                continue;
+            }
+            SNode* other = static_cast<SNode*>(branch);
+            if (other->key == sn->key) return kAbsent;
+            // Both keys land on this branch: push them down a level
+            CNode* below = dual(other, sn, lev + kBits, in->gen);
+            INode* child = new INode(below, in->gen);
+            CNode* n = updatedAt(cn, pos, child, in->gen);
+            if (gcas(in, cn, n)) {
+                dispose(cn, in->gen, tid);
+                return kDone;
+            }
+            retireDual(below, tid);
+            reclaimer.retire(child, tid);
+            reclaimer.retire(n, tid);
+            return kRestart;
+        }
+    }
+
+    Result removeAt(INode* in, int key, int tid) {
+        INode* parent = nullptr;
+        uint32_t hash = key;
+        for (int lev = 0;;) {
+            MainNode* m = gcasRead(in, false);
+            if (m->kind == kTNode) {
+                clean(parent, lev - kBits, tid);
+                return kRestart;
+            }
+            CNode* cn = static_cast<CNode*>(m);
+            if (cn->gen != in->gen) {
+                if (renew(in, cn, tid)) continue;
+                return kRestart;
+            }
+            uint32_t flag = flagOf(hash, lev);
+            if (!(cn->bitmap & flag)) return kAbsent;
+            int pos = posOf(cn->bitmap, flag);
+            Node* branch = cn->array[pos];
+            if (branch->kind == kINode) {
+                parent = in;
+                in = static_cast<INode*>(branch);
+                lev += kBits;
+                continue;
+            }
+            SNode* sn = static_cast<SNode*>(branch);
+            if (sn->key != key) return kAbsent;
+            MainNode* n = toContracted(removedAt(cn, pos, flag, in->gen), lev);
+            if (!gcas(in, cn, n)) {
+                reclaimer.retire(n, tid);
+                return kRestart;
+            }
+            dispose(cn, in->gen, tid);
+            dispose(sn, in->gen, tid);
+            if (parent && n->kind == kTNode) cleanParent(parent, in, hash, lev - kBits, tid);
+            return kDone;
+        }
+    }
+
+    // Pulls the keys of tombed children of p's C-node up into it
+    void clean(INode* p, int lev, int tid) {
+        if (!p) return;
+        MainNode* m = gcasRead(p, false);
+        if (m->kind != kCNode || m->gen != p->gen) return;
+        CNode* cn = static_cast<CNode*>(m);
+        CNode* n = new CNode(cn->bitmap, cn->size, p->gen);
+        INode* dead[32];
+        TNode* tombs[32];
+        int resurrected = 0;
+        for (int i = 0; i < cn->size; ++i) {
+            Node* branch = cn->array[i];
+            n->array[i] = branch;
+            if (branch->kind != kINode) continue;
+            MainNode* sub = gcasRead(static_cast<INode*>(branch), false);
+            if (sub->kind != kTNode) continue;
+            dead[resurrected] = static_cast<INode*>(branch);
+            tombs[resurrected++] = static_cast<TNode*>(sub);
+            n->array[i] = static_cast<TNode*>(sub)->sn;
+        }
+        if (!resurrected) {
+            delete n;
+            return;
+        }
+        MainNode* compressed = toContracted(n, lev);
+        if (!gcas(p, cn, compressed)) {
+            reclaimer.retire(compressed, tid);
+            return;
+        }
+        dispose(cn, p->gen, tid);
+        for (int i = 0; i < resurrected; ++i) {
+            dispose(dead[i], p->gen, tid);
+            dispose(tombs[i], p->gen, tid);
+        }
+    }
+
+    // After a remove tombed in's C-node, replace in by its last key in p
+    void cleanParent(INode* p, INode* in, uint32_t hash, int lev, int tid) {
+        while (true) {
+            MainNode* m = gcasRead(in, false);
+            if (m->kind != kTNode) return;
+            MainNode* pm = gcasRead(p, false);
+            if (pm->kind != kCNode || pm->gen != p->gen) return;
+            CNode* cn = static_cast<CNode*>(pm);
+            uint32_t flag = flagOf(hash, lev);
+            if (!(cn->bitmap & flag)) return;
+            int pos = posOf(cn->bitmap, flag);
+            if (cn->array[pos] != in) return;
+            TNode* tomb = static_cast<TNode*>(m);
+            MainNode* n = toContracted(updatedAt(cn, pos, tomb->sn, p->gen), lev);
+            if (gcas(p, cn, n)) {
+                dispose(cn, p->gen, tid);
+                dispose(in, p->gen, tid);
+                dispose(tomb, p->gen, tid);
+                return;
+            }
+            reclaimer.retire(n, tid);
+            if (readRoot(false)->gen != p->gen) return;
+        }
+    }
+
+    void freeTree(INode* in) {
+        MainNode* m = in->main.load();
+        if (m->kind == kTNode) {
+            delete static_cast<TNode*>(m)->sn;
+        } else {
+            CNode* cn = static_cast<CNode*>(m);
+            for (int i = 0; i < cn->size; ++i) {
+                if (cn->array[i]->kind == kINode) freeTree(static_cast<INode*>(cn->array[i]));
+                else delete cn->array[i];
+            }
+        }
+        delete m;
+        delete in;
+    }
+};
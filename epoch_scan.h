@@ -0,0 +1,72 @@
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <immintrin.h>
+
+// Vectorized scans over per-thread epoch reservations.
+//
+// The reservation array is a packed int array with one entry per registered
+// thread and INT_MAX marking threads that are outside an operation, so the
+// minimum active epoch is a plain horizontal min. The AVX2 and SSE4.1 kernels
+// are compiled with target attributes and picked once at runtime via cpuid,
+// so the benchmarks still build with the plain `g++ -O3` line in the README.
+namespace epoch_scan {
+
+inline int min_epoch_scalar(const int* epochs, size_t n) {
+    int result = INT_MAX;
+    for (size_t i = 0; i < n; ++i) {
+        if (epochs[i] < result) result = epochs[i];
+    }
+    return result;
+}
+
+__attribute__((target("sse4.1")))
+inline int min_epoch_sse41(const int* epochs, size_t n) {
+    __m128i acc = _mm_set1_epi32(INT_MAX);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm_min_epi32(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(epochs + i)));
+    }
+    acc = _mm_min_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_min_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    int result = _mm_cvtsi128_si32(acc);
+    for (; i < n; ++i) {
+        if (epochs[i] < result) result = epochs[i];
+    }
+    return result;
+}
+
+__attribute__((target("avx2")))
+inline int min_epoch_avx2(const int* epochs, size_t n) {
+    __m256i acc = _mm256_set1_epi32(INT_MAX);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_min_epi32(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(epochs + i)));
+    }
+    __m128i half = _mm_min_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    half = _mm_min_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_min_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    int result = _mm_cvtsi128_si32(half);
+    for (; i < n; ++i) {
+        if (epochs[i] < result) result = epochs[i];
+    }
+    return result;
+}
+
+using MinEpochFn = int (*)(const int*, size_t);
+
+inline MinEpochFn select_min_epoch() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return min_epoch_avx2;
+    if (__builtin_cpu_supports("sse4.1")) return min_epoch_sse41;
+    return min_epoch_scalar;
+}
+
+// Minimum of epochs[0..n), INT_MAX when n == 0 or nobody is active.
+inline int min_epoch(const int* epochs, size_t n) {
+    static const MinEpochFn kernel = select_min_epoch();
+    return kernel(epochs, n);
+}
+
+} // namespace epoch_scan
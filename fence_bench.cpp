@@ -0,0 +1,128 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hyaline.h"
+#include "ibr_manager.h"
+
+// Read-heavy microbenchmark for reader-side publication cost: every operation
+// enters a critical section and reads one of a small set of shared cells, and
+// a small fraction of operations replace a cell and retire the old value.
+// Each scheme runs with the usual store-load fence and with asymmetric fences.
+
+struct HyalineCell : HyalineNode {
+    int value;
+    HyalineCell(int v) : value(v) {}
+};
+
+struct IBRCell : IBRNode {
+    int value;
+    IBRCell(int v) : value(v) {}
+};
+
+const int cells = 1024;
+const int ops_per_thread = 1000000;
+
+double run_hyaline(int threads, int read_percent, bool asymmetric) {
+    Hyaline hyaline(threads);
+    if (asymmetric && !hyaline.setAsymmetricFences(true)) return -1;
+    std::vector<std::atomic<HyalineCell*>> table(cells);
+    for (auto& cell : table) cell.store(new HyalineCell(0));
+
+    std::atomic<long> sink{0};
+    std::vector<std::thread> workers;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            std::mt19937 gen(i);
+            long sum = 0;
+            for (int j = 0; j < ops_per_thread; ++j) {
+                int index = gen() % cells;
+                hyaline.enter(i);
+                if (static_cast<int>(gen() % 100) < read_percent) {
+                    sum += table[index].load(std::memory_order_acquire)->value;
+                } else {
+                    HyalineCell* old = table[index].exchange(new HyalineCell(j));
+                    hyaline.retire(old, i);
+                }
+                hyaline.leave(i);
+            }
+            sink.fetch_add(sum, std::memory_order_relaxed);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    for (auto& cell : table) delete cell.load();
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    return static_cast<double>(threads) * ops_per_thread / elapsed.count();
+}
+
+double run_ibr(int threads, int read_percent, bool asymmetric) {
+    if (IBRManager::set_asymmetric_fences(asymmetric) != asymmetric) return -1;
+    std::vector<std::atomic<IBRCell*>> table(cells);
+    for (auto& cell : table) cell.store(IBRManager::allocate_node<IBRCell>(0));
+
+    std::atomic<long> sink{0};
+    std::atomic<int> finished{0};
+    std::vector<std::thread> workers;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            std::mt19937 gen(i);
+            long sum = 0;
+            for (int j = 0; j < ops_per_thread; ++j) {
+                int index = gen() % cells;
+                IBRManager::start_op();
+                if (static_cast<int>(gen() % 100) < read_percent) {
+                    sum += table[index].load(std::memory_order_acquire)->value;
+                } else {
+                    IBRCell* old = table[index].exchange(IBRManager::allocate_node<IBRCell>(j));
+                    IBRManager::retire_node(old);
+                }
+                IBRManager::end_op();
+            }
+            sink.fetch_add(sum, std::memory_order_relaxed);
+            // retired_nodes is thread-local, so free it here once nobody is inside an operation
+            finished.fetch_add(1);
+            while (finished.load() < threads) std::this_thread::yield();
+            IBRManager::final_clean_up();
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+
+    for (auto& cell : table) delete cell.load();
+    IBRManager::set_asymmetric_fences(false);
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    return static_cast<double>(threads) * ops_per_thread / elapsed.count();
+}
+
+void report(const char* scheme, const char* mode, double throughput) {
+    std::cout << scheme << " | " << mode << " | ";
+    if (throughput < 0) {
+        std::cout << "membarrier not supported" << std::endl;
+    } else {
+        std::cout << "Throughput: " << throughput << " ops/sec" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int threads = argc >= 2 ? std::stoi(argv[1]) : 4;
+    int read_percent = argc >= 3 ? std::stoi(argv[2]) : 95;
+    std::cout << "The thread count is: " << threads << " | Reads: " << read_percent << "%" << std::endl;
+
+    report("Hyaline", "fenced    ", run_hyaline(threads, read_percent, false));
+    report("Hyaline", "asymmetric", run_hyaline(threads, read_percent, true));
+    report("IBR    ", "fenced    ", run_ibr(threads, read_percent, false));
+    report("IBR    ", "asymmetric", run_ibr(threads, read_percent, true));
+    return 0;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "spin_locks.h"
+
+// Flat combining (Hendler, Incze, Shavit and Tzafrir, SPAA 2010) around a
+// map that is only safe under a single lock. A thread posts its operation
+// to its own publication record and waits. Whoever wins the combiner lock
+// runs every pending operation against the map in one batch, while the
+// map and its lock stay in that core's cache, and hands each result back
+// through the owner's record.
+//
+// The map is only ever touched by the current combiner. The operations are
+// given the combiner's tid, since that is the thread running them.
+template <class Map>
+class FlatCombining {
+public:
+    template <class... Args>
+    explicit FlatCombining(int threads, Args&&... args) : map(std::forward<Args>(args)...), records(threads) {}
+
+    // Runs op(map, tid) as part of some combiner's batch and returns its result
+    template <class Op>
+    auto apply(Op op, int tid) -> decltype(op(std::declval<Map&>(), tid)) {
+        using Result = decltype(op(std::declval<Map&>(), tid));
+        std::optional<Result> result;
+        auto call = [&](Map& m, int combiner) { result.emplace(op(m, combiner)); };
+        using Call = decltype(call);
+
+        // The record points into this frame, which outlives the wait below
+        Record& r = records[tid];
+        r.context = &call;
+        r.run = [](void* context, Map& m, int combiner) { (*static_cast<Call*>(context))(m, combiner); };
+        r.pending.store(true, std::memory_order_release);
+
+        int spins = 0;
+        while (r.pending.load(std::memory_order_acquire)) {
+            if (!combining.load(std::memory_order_relaxed) && !combining.exchange(true, std::memory_order_acquire)) {
+                combine(tid);
+                combining.store(false, std::memory_order_release);
+            } else {
+                spinWait(spins);
+            }
+        }
+        return std::move(*result);
+    }
+
+    // The SGLUnorderedMap interface, each operation combined
+    template <class K, class V>
+    bool insert(K key, V val, int tid) {
+        return apply([&](Map& m, int t) { return m.insert(key, val, t); }, tid);
+    }
+
+    template <class K, class V>
+    auto put(K key, V val, int tid) {
+        return apply([&](Map& m, int t) { return m.put(key, val, t); }, tid);
+    }
+
+    template <class K, class V>
+    auto replace(K key, V val, int tid) {
+        return apply([&](Map& m, int t) { return m.replace(key, val, t); }, tid);
+    }
+
+    template <class K>
+    auto remove(K key, int tid) {
+        return apply([&](Map& m, int t) { return m.remove(key, t); }, tid);
+    }
+
+    template <class K>
+    auto get(K key, int tid) {
+        return apply([&](Map& m, int t) { return m.get(key, t); }, tid);
+    }
+
+    // Mean operations run per combining pass; read once the workers are done
+    double averageBatch() const { return batches ? static_cast<double>(operations) / batches : 0; }
+
+private:
+    // Scans over the records per turn as combiner; later scans pick up
+    // operations posted while the earlier ones ran
+    static constexpr int kPasses = 3;
+
+    struct alignas(64) Record {
+        std::atomic<bool> pending{false};
+        void* context = nullptr;
+        void (*run)(void*, Map&, int) = nullptr;
+    };
+
+    void combine(int tid) {
+        for (int pass = 0; pass < kPasses; ++pass) {
+            long ran = 0;
+            for (Record& r : records) {
+                if (!r.pending.load(std::memory_order_acquire)) continue;
+                r.run(r.context, map, tid);
+                r.pending.store(false, std::memory_order_release);
+                ++ran;
+            }
+            if (!ran) break;
+            operations += ran;
+            ++batches;
+        }
+    }
+
+    Map map;
+    std::vector<Record> records;
+    alignas(64) std::atomic<bool> combining{false};
+    long batches = 0;    // Only touched by the combiner
+    long operations = 0;
+};
@@ -0,0 +1,14 @@
+#include "harris_list.h"
+#include "set_bench.h"
+
+// Harris-Michael list under each reclamation scheme. Every operation walks
+// about half the list, so one critical section touches thousands of nodes.
+int main(int argc, char* argv[]) {
+    SetWorkload defaults;
+    defaults.keyRange = 4000;
+    defaults.opsPerThread = 20000;
+    SetWorkload workload = parseSetWorkload(argc, argv, defaults);
+    runSetWorkload<HarrisMichaelList, HyalineReclaimer>(workload);
+    runSetWorkload<HarrisMichaelList, IBRReclaimer>(workload);
+    return 0;
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+
+// Harris-Michael lock-free sorted linked list (Harris 2001, Michael 2002).
+// A remove first marks the victim's next pointer (logical deletion), then
+// swings its predecessor past it (physical unlink); any traversal that meets
+// a marked node unlinks it on the way. The thread whose unlink CAS succeeds
+// retires the node, so every node is retired exactly once.
+//
+// Nodes carry a value so the list can back a map. A remove seals the value
+// before marking the node: that exchange is its linearization point, and a
+// put that loses the race sees the seal instead of writing into a node that
+// is on its way out. A sealed node counts as absent; whoever meets one helps
+// mark it so it gets unlinked.
+//
+// The list operations work on any head link, so a hash map can keep one list
+// per bucket and reuse them. Callers of the *At functions must be inside
+// reclaimer.enter/leave.
+template <class Reclaimer, class K = int, class V = int>
+class HarrisMichaelList {
+    static_assert(std::is_integral<V>::value && sizeof(V) <= 4, "values are packed next to a seal bit");
+
+public:
+    using Link = std::atomic<uintptr_t>; // Next pointer | kMark
+
+    struct Node : Reclaimer::Node {
+        const K key;
+        std::atomic<int64_t> value; // V, or kSealed once removed
+        Link next;
+
+        Node(K k, V v) : key(k), value(v), next(0) {}
+    };
+
+    explicit HarrisMichaelList(Reclaimer& reclaimer) : reclaimer(reclaimer), head(0) {}
+
+    ~HarrisMichaelList() {
+        freeList(head);
+    }
+
+    bool insert(K key, int tid) {
+        reclaimer.enter(tid);
+        bool inserted = insertAt(reclaimer, head, key, V(), tid);
+        reclaimer.leave(tid);
+        return inserted;
+    }
+
+    bool remove(K key, int tid) {
+        reclaimer.enter(tid);
+        bool removed = removeAt(reclaimer, head, key, tid).has_value();
+        reclaimer.leave(tid);
+        return removed;
+    }
+
+    bool contains(K key, int tid) {
+        reclaimer.enter(tid);
+        bool found = getAt(head, key).has_value();
+        reclaimer.leave(tid);
+        return found;
+    }
+
+    // Where a key is, or would be inserted: *prev held curr, unmarked, when seen
+    struct Position {
+        Link* prev;
+        Node* curr;
+        uintptr_t next;
+    };
+
+    // Position of the first node with a key >= key; unlinks and retires any
+    // marked node it passes. Returns whether that node holds key.
+    static bool find(Reclaimer& reclaimer, Link& head, const K& key, Position& pos, int tid) {
+    retry:
+        pos.prev = &head;
+        pos.curr = address(head.load(std::memory_order_acquire));
+        while (pos.curr) {
+            pos.next = pos.curr->next.load(std::memory_order_acquire);
+            if (pos.next & kMark) {
+                uintptr_t expected = link(pos.curr);
+                if (!pos.prev->compare_exchange_strong(expected, pos.next & ~kMark)) {
+                    goto retry; // prev changed or was itself marked
+                }
+                reclaimer.retire(pos.curr, tid);
+                pos.curr = address(pos.next);
+                continue;
+            }
+            if (!(pos.curr->key < key)) {
+                return pos.curr->key == key;
+            }
+            pos.prev = &pos.curr->next;
+            pos.curr = address(pos.next);
+        }
+        return false;
+    }
+
+    // Insert key if absent; *holder, if given, receives the node holding key either way
+    static bool insertAt(Reclaimer& reclaimer, Link& head, const K& key, V value, int tid,
+                         Node** holder = nullptr) {
+        Position pos;
+        Node* node = nullptr;
+        while (true) {
+            if (find(reclaimer, head, key, pos, tid)) {
+                if (pos.curr->value.load(std::memory_order_acquire) != kSealed) {
+                    delete node; // Never published
+                    if (holder) *holder = pos.curr;
+                    return false;
+                }
+                mark(pos.curr);
+                continue;
+            }
+            if (!node) node = new Node(key, value);
+            if (link(node, pos)) {
+                if (holder) *holder = node;
+                return true;
+            }
+        }
+    }
+
+    // Insert or overwrite; returns the previous value
+    static std::optional<V> putAt(Reclaimer& reclaimer, Link& head, const K& key, V value, int tid) {
+        Position pos;
+        Node* node = nullptr;
+        while (true) {
+            if (find(reclaimer, head, key, pos, tid)) {
+                int64_t old = pos.curr->value.load(std::memory_order_acquire);
+                while (old != kSealed) {
+                    if (pos.curr->value.compare_exchange_weak(old, value)) {
+                        delete node; // Never published
+                        return static_cast<V>(old);
+                    }
+                }
+                mark(pos.curr);
+                continue;
+            }
+            if (!node) node = new Node(key, value);
+            if (link(node, pos)) return std::nullopt;
+        }
+    }
+
+    // Overwrite only if present; returns the previous value
+    static std::optional<V> replaceAt(Reclaimer& reclaimer, Link& head, const K& key, V value, int tid) {
+        Position pos;
+        while (find(reclaimer, head, key, pos, tid)) {
+            int64_t old = pos.curr->value.load(std::memory_order_acquire);
+            while (old != kSealed) {
+                if (pos.curr->value.compare_exchange_weak(old, value)) {
+                    return static_cast<V>(old);
+                }
+            }
+            mark(pos.curr);
+        }
+        return std::nullopt;
+    }
+
+    // Returns the removed value
+    static std::optional<V> removeAt(Reclaimer& reclaimer, Link& head, const K& key, int tid) {
+        Position pos;
+        while (find(reclaimer, head, key, pos, tid)) {
+            int64_t old = pos.curr->value.load(std::memory_order_acquire);
+            while (old != kSealed) {
+                if (pos.curr->value.compare_exchange_weak(old, kSealed)) {
+                    // Logical deletion: marked after the seal, so the mark is ours or a helper's
+                    uintptr_t next = mark(pos.curr);
+                    uintptr_t expected = link(pos.curr);
+                    if (pos.prev->compare_exchange_strong(expected, next & ~kMark)) {
+                        reclaimer.retire(pos.curr, tid);
+                    } else {
+                        find(reclaimer, head, key, pos, tid); // Let a traversal unlink it
+                    }
+                    return static_cast<V>(old);
+                }
+            }
+            mark(pos.curr);
+        }
+        return std::nullopt;
+    }
+
+    // Wait-free read: skips marked nodes instead of unlinking them
+    static std::optional<V> getAt(Link& head, const K& key) {
+        Node* curr = address(head.load(std::memory_order_acquire));
+        while (curr && curr->key < key) {
+            curr = address(curr->next.load(std::memory_order_acquire));
+        }
+        if (!curr || !(curr->key == key)) return std::nullopt;
+        int64_t value = curr->value.load(std::memory_order_acquire);
+        if (value == kSealed) return std::nullopt;
+        return static_cast<V>(value);
+    }
+
+    // Only when no other thread can reach the list any more
+    static void freeList(Link& head) {
+        Node* curr = address(head.load());
+        while (curr) {
+            Node* next = address(curr->next.load());
+            delete curr;
+            curr = next;
+        }
+        head.store(0);
+    }
+
+private:
+    static constexpr uintptr_t kMark = 1;
+    static constexpr int64_t kSealed = INT64_MIN; // Outside the range of any V
+
+    Reclaimer& reclaimer;
+    Link head;
+
+    static uintptr_t link(Node* node) { return reinterpret_cast<uintptr_t>(node); }
+    static Node* address(uintptr_t field) { return reinterpret_cast<Node*>(field & ~kMark); }
+
+    static bool link(Node* node, const Position& pos) {
+        node->next.store(link(pos.curr), std::memory_order_relaxed);
+        uintptr_t expected = link(pos.curr);
+        return pos.prev->compare_exchange_strong(expected, link(node));
+    }
+
+    // Mark a sealed node's next pointer; returns the marked value
+    static uintptr_t mark(Node* node) {
+        uintptr_t next = node->next.load(std::memory_order_acquire);
+        while (!(next & kMark) && !node->next.compare_exchange_weak(next, next | kMark)) {
+        }
+        return next | kMark;
+    }
+};
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "asymmetric_fence.h"
+#include "spsc_ring.h"
+
+// Header embedded in every object retired through Hyaline
+struct HyalineNode {
+    HyalineNode* next = nullptr;      // Link in a slot's retired list
+    HyalineNode* batchNext = nullptr; // Link to the next node of the same batch
+    HyalineNode* refs = nullptr;      // Node holding the batch's reference counter
+    std::atomic<long> refCount{0};    // Slots still referencing the batch (refs node only)
+
+    virtual ~HyalineNode() = default;
+};
+
+// Hyaline-1 (Nikolaev & Ravindran): each slot is owned by one thread at a time.
+// Retired nodes are grouped into batches of at least numSlots + 1 nodes; a full
+// batch is linked into the list of every slot that is currently inside a
+// critical section, and the last slot to leave frees the batch.
+class Hyaline {
+public:
+    // With background set, retired batches and the lists detached in leave()
+    // are handed to a dedicated reclaimer thread instead of being processed
+    // on the caller's operation path.
+    Hyaline(int numSlots, bool background = false)
+        : slots(numSlots), slotCount(numSlots), background(background) {
+        if (background) {
+            reclaimer = std::thread([this] { reclaimerLoop(); });
+        }
+    }
+
+    ~Hyaline() {
+        if (background) {
+            running.store(false, std::memory_order_release);
+            reclaimer.join();
+        }
+        // No slot is active any more, so pending batches are freed outright
+        for (auto& slot : slots) {
+            flush(slot.batch);
+        }
+    }
+
+    // Enter the critical section
+    void enter(int slotId) {
+        if (asymmetric) {
+            // flush() issues the matching membarrier before it looks at slots
+            slots[slotId].head.store(kActive, std::memory_order_relaxed);
+            asymmetric_fence::light();
+        } else {
+            // seq_cst: the slot must look active before we read shared nodes
+            slots[slotId].head.store(kActive);
+        }
+    }
+
+    // Leave the critical section
+    void leave(int slotId) {
+        Slot& slot = slots[slotId];
+        uintptr_t head = slot.head.exchange(0, std::memory_order_acq_rel);
+        HyalineNode* list = reinterpret_cast<HyalineNode*>(head & ~kActive);
+        if (list && !(background && slot.handoff.push(reinterpret_cast<uintptr_t>(list) | kDetachedList))) {
+            traverse(list);
+        }
+        if (slot.pressurePending) relievePressure(slot);
+    }
+
+    // Retire a batch of nodes linked through batchNext
+    void retire(HyalineNode* batchHead, int slotId) {
+        Slot& slot = slots[slotId];
+        long count = 0;
+        for (HyalineNode* node = batchHead; node; node = node->batchNext) ++count;
+        unreclaimed.fetch_add(count, std::memory_order_relaxed);
+
+        if (!background || !slot.handoff.push(reinterpret_cast<uintptr_t>(batchHead))) {
+            append(slot.batch, batchHead);
+            if (slot.batch.size > slotCount) flush(slot.batch);
+        }
+
+        // Relieved in leave(), once this slot no longer holds anything back
+        if (budget > 0 && unreclaimed.load(std::memory_order_relaxed) > budget) {
+            slot.pressurePending = true;
+        }
+    }
+
+    // Cap on retired-but-unfreed nodes across all slots; 0 disables the cap
+    void setBudget(long nodes) { budget = nodes; }
+
+    // Drop the store-load fence from enter() and have reclaimers issue a
+    // membarrier instead. Call before any thread enters; returns whether the
+    // mode is in effect (false if the kernel lacks membarrier).
+    bool setAsymmetricFences(bool enable) {
+        asymmetric = enable && asymmetric_fence::init();
+        return asymmetric;
+    }
+
+    long unreclaimedNodes() const { return unreclaimed.load(std::memory_order_relaxed); }
+
+    // How often each stage of the over-budget path fired; retire() notices the
+    // overrun and leave() deals with it. Hyaline has no global epoch to
+    // advance, so it goes straight from scan to stall.
+    long pressureScans() const { return scans.load(std::memory_order_relaxed); }
+    long pressureStalls() const { return stalls.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uintptr_t kActive = 1;       // Low bit of Slot::head
+    static constexpr uintptr_t kDetachedList = 1; // Low bit of a handoff entry
+    static constexpr size_t kHandoffSize = 256;
+    static constexpr int kMaxBackoffRounds = 10;  // Backpressure sleeps 1us..512us per round
+
+    struct Batch {
+        HyalineNode* first = nullptr;
+        HyalineNode* last = nullptr;
+        int size = 0;
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<uintptr_t> head{0}; // Retired list of the current critical section | kActive
+        Batch batch;                    // Batch being filled by the slot's owner
+        std::vector<char> active;       // Owner's snapshot of active slots for early flushes
+        SpscRing<uintptr_t, kHandoffSize> handoff; // Owner -> reclaimer thread
+        bool pressurePending = false;   // Went over budget in the current critical section
+    };
+
+    std::vector<Slot> slots;
+    const int slotCount;
+    const bool background;
+    std::atomic<bool> running{true};
+    std::thread reclaimer;
+
+    long budget = 0;
+    bool asymmetric = false;
+    std::atomic<long> unreclaimed{0};
+    std::atomic<long> scans{0};
+    std::atomic<long> stalls{0};
+
+    static void append(Batch& batch, HyalineNode* chain) {
+        if (!batch.first) {
+            batch.first = chain;
+        } else {
+            batch.last->batchNext = chain;
+        }
+        for (HyalineNode* node = chain; node; node = node->batchNext) {
+            batch.last = node;
+            ++batch.size;
+        }
+    }
+
+    // Insert the batch into every active slot; the first node keeps the counter.
+    // With a snapshot, only slots that were active in it are considered: a slot
+    // that entered after the snapshot cannot see nodes unlinked before it.
+    void flush(Batch& batch, const std::vector<char>* snapshot = nullptr) {
+        HyalineNode* refs = batch.first;
+        if (!refs) return;
+        batch = Batch();
+
+        for (HyalineNode* node = refs->batchNext; node; node = node->batchNext) {
+            node->refs = refs;
+        }
+
+        // Pairs with the seq_cst store in enter()
+        fenceBeforeScan();
+        long inserted = 0;
+        HyalineNode* current = refs->batchNext;
+        for (int i = 0; i < slotCount; ++i) {
+            if (!current) break;
+            if (snapshot && !(*snapshot)[i]) continue;
+            Slot& slot = slots[i];
+            uintptr_t head = slot.head.load(std::memory_order_acquire);
+            do {
+                if (!(head & kActive)) break;
+                current->next = reinterpret_cast<HyalineNode*>(head & ~kActive);
+            } while (!slot.head.compare_exchange_weak(head, reinterpret_cast<uintptr_t>(current) | kActive,
+                                                      std::memory_order_acq_rel));
+            if (head & kActive) {
+                ++inserted;
+                current = current->batchNext;
+            }
+        }
+
+        if (refs->refCount.fetch_add(inserted, std::memory_order_acq_rel) == -inserted) {
+            freeBatch(refs);
+        }
+    }
+
+    void fenceBeforeScan() const {
+        if (asymmetric) {
+            asymmetric_fence::heavy();
+        } else {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    // Flush a batch smaller than numSlots + 1 if it still covers every active slot
+    bool flushEarly(Batch& batch, std::vector<char>& snapshot) {
+        snapshot.resize(slotCount);
+        fenceBeforeScan();
+        int active = 0;
+        for (int i = 0; i < slotCount; ++i) {
+            snapshot[i] = slots[i].head.load(std::memory_order_acquire) & kActive;
+            active += snapshot[i];
+        }
+        if (batch.size <= active) return false;
+        flush(batch, &snapshot);
+        return true;
+    }
+
+    // Over budget: flush our partial batch now, then slow the caller down.
+    // Runs after leave() has released the slot, so the caller is not among the
+    // slots it waits for. A stalled slot pins every batch inserted while it is
+    // active, so the stall is bounded rather than waiting for that slot
+    // indefinitely.
+    void relievePressure(Slot& slot) {
+        slot.pressurePending = false;
+        if (unreclaimed.load(std::memory_order_relaxed) <= budget) return;
+
+        scans.fetch_add(1, std::memory_order_relaxed);
+        flushEarly(slot.batch, slot.active);
+        if (unreclaimed.load(std::memory_order_relaxed) <= budget) return;
+
+        stalls.fetch_add(1, std::memory_order_relaxed);
+        for (int round = 0; round < kMaxBackoffRounds; ++round) {
+            std::this_thread::sleep_for(std::chrono::microseconds(1 << round));
+            if (unreclaimed.load(std::memory_order_relaxed) <= budget) return;
+        }
+    }
+
+    // Drop this slot's reference on every batch in a detached list
+    void traverse(HyalineNode* current) {
+        while (current) {
+            HyalineNode* next = current->next;
+            HyalineNode* refs = current->refs;
+            if (refs->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                freeBatch(refs);
+            }
+            current = next;
+        }
+    }
+
+    void freeBatch(HyalineNode* refs) {
+        long freed = 0;
+        while (refs) {
+            HyalineNode* next = refs->batchNext;
+            delete refs;
+            refs = next;
+            ++freed;
+        }
+        unreclaimed.fetch_sub(freed, std::memory_order_relaxed);
+    }
+
+    bool drainHandoffs(Batch& batch) {
+        bool drained = false;
+        uintptr_t entry;
+        for (auto& slot : slots) {
+            while (slot.handoff.pop(entry)) {
+                drained = true;
+                if (entry & kDetachedList) {
+                    traverse(reinterpret_cast<HyalineNode*>(entry & ~kDetachedList));
+                } else {
+                    append(batch, reinterpret_cast<HyalineNode*>(entry));
+                    if (batch.size > slotCount) flush(batch);
+                }
+            }
+        }
+        return drained;
+    }
+
+    void reclaimerLoop() {
+        Batch batch;
+        while (running.load(std::memory_order_acquire)) {
+            if (!drainHandoffs(batch)) std::this_thread::yield();
+        }
+        drainHandoffs(batch);
+        flush(batch);
+    }
+};
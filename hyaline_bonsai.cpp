@@ -1,197 +1,790 @@
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string_view>
 #include <thread>
+#include <type_traits>
 #include <vector>
 #include <memory>
 #include <iostream>
 #include <random>
+#include <string>
 
-// Node structure with retirement handling
-struct Node {
-    int key;                   // Key for the Bonsai Tree
-    std::atomic<int> refCount; // Reference counter
-    Node* left;                // Left child
-    Node* right;               // Right child
-    Node* next;                // Pointer for Hyaline batch
+#include "hyaline.h"
 
-    Node(int k) : key(k), refCount(0), left(nullptr), right(nullptr), next(nullptr) {}
-};
+// One contiguous block of nodes, filled by BonsaiTree::bulkLoad. Every node,
+// from an arena or from the heap, is preceded by a header naming its arena
+// (null for the heap), so arena nodes are retired and deleted like any
+// other; the block goes back to the heap once its last node is deleted.
+struct NodeArena {
+    static constexpr size_t kHeader = alignof(std::max_align_t);
+
+    std::atomic<size_t> live;
+    const size_t stride;
+    char* const block;
+
+    NodeArena(size_t nodes, size_t nodeSize)
+        : live(nodes), stride((kHeader + nodeSize + kHeader - 1) / kHeader * kHeader),
+          block(static_cast<char*>(::operator new(nodes * stride))) {}
 
-// Slot structure for maintaining retirement lists
-struct Slot {
-    std::atomic<int> refCount; // Global reference counter for this slot
-    std::atomic<Node*> head;  // Head of the retired list
+    void* node(size_t index) { return block + index * stride + kHeader; }
+
+    static void* allocate(size_t size) {
+        char* base = static_cast<char*>(::operator new(kHeader + size));
+        *reinterpret_cast<NodeArena**>(base) = nullptr;
+        return base + kHeader;
+    }
 
-    Slot() : refCount(0), head(nullptr) {}
+    void* place(size_t index) {
+        char* base = block + index * stride;
+        *reinterpret_cast<NodeArena**>(base) = this;
+        return base + kHeader;
+    }
+
+    static void release(void* p) {
+        char* base = static_cast<char*>(p) - kHeader;
+        NodeArena* arena = *reinterpret_cast<NodeArena**>(base);
+        if (!arena) {
+            ::operator delete(base);
+        } else if (arena->live.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            ::operator delete(arena->block);
+            delete arena;
+        }
+    }
 };
 
-class Hyaline {
+// How a node holds its key. By default the key is stored as is and ordered
+// by Compare.
+template <class K, class Compare>
+class KeyPolicy {
 public:
-    Hyaline(int numSlots) : slots(numSlots), slotCount(numSlots) {}
+    using Stored = K;
+    using View = const K&;
 
-    // Enter the critical section
-    Node* enter(int slotId) {
-        Slot& slot = slots[slotId];
-        slot.refCount.fetch_add(1, std::memory_order_relaxed);
-        return slot.head.load(std::memory_order_acquire);
-    }
+    static const K& probe(const K& key) { return key; }
+    Stored intern(const K& key) { return key; }
+    static View view(const Stored& key) { return key; }
+    bool less(const K& a, const K& b) const { return compare(a, b); }
 
-    // Leave the critical section
-    void leave(int slotId, Node* handle) {
-        Slot& slot = slots[slotId];
-        auto head = slot.head.load(std::memory_order_acquire);
-        auto ref = slot.refCount.fetch_sub(1, std::memory_order_release);
+private:
+    Compare compare;
+};
 
-        if (ref == 1 && head) { // This thread may need to handle reclamation
-            traverseAndReclaim(slot, head);
+// String keys in byte order are interned: their bytes are copied once into
+// an append-only arena, and every node for the key, including the copies
+// made while rebalancing, points at that one copy. The first 8 bytes are
+// cached big-endian in the node, so comparing two cached prefixes as
+// integers orders them like memcmp, and only keys sharing a prefix touch
+// their bytes. Bytes of removed keys stay in the arena until the tree goes.
+template <>
+class KeyPolicy<std::string, std::less<std::string>> {
+public:
+    struct Stored {
+        const char* data;
+        uint32_t length;
+        uint64_t prefix;
+    };
+    using View = std::string_view;
+
+    KeyPolicy() = default;
+    KeyPolicy(const KeyPolicy&) = delete;
+
+    ~KeyPolicy() {
+        for (Chunk* chunk : chunks) {
+            delete[] chunk->bytes;
+            delete chunk;
         }
     }
 
-    // Retire a batch of nodes
-    void retire(Node* batchHead, int slotId) {
-        Slot& slot = slots[slotId];
+    // A probe refers to the caller's string and is only valid while it lives
+    static Stored probe(const std::string& key) {
+        return {key.data(), static_cast<uint32_t>(key.size()), prefixOf(key.data(), key.size())};
+    }
 
-        Node* prevHead = nullptr;
-        do {
-            prevHead = slot.head.load(std::memory_order_acquire);
-            batchHead->next = prevHead;
-        } while (!slot.head.compare_exchange_weak(prevHead, batchHead, std::memory_order_release));
+    Stored intern(const std::string& key) {
+        Stored stored = probe(key);
+        stored.data = copy(key.data(), key.size());
+        return stored;
     }
 
-private:
-    std::vector<Slot> slots;
-    const int slotCount;
+    static View view(const Stored& key) { return {key.data, key.length}; }
+
+    bool less(const Stored& a, const Stored& b) const {
+        if (a.prefix != b.prefix) return a.prefix < b.prefix;
+        if (a.length <= 8 && b.length <= 8) return a.length < b.length;
+        int order = std::memcmp(a.data, b.data, std::min(a.length, b.length));
+        return order < 0 || (order == 0 && a.length < b.length);
+    }
 
-    // Traverse and reclaim retired nodes
-    void traverseAndReclaim(Slot& slot, Node* handle) {
-        Node* current = slot.head.load(std::memory_order_acquire);
+private:
+    static constexpr size_t kChunk = 1 << 20;
+
+    struct Chunk {
+        char* bytes;
+        size_t capacity;
+        std::atomic<size_t> used{0};
+    };
+
+    std::mutex refill;
+    std::vector<Chunk*> chunks;
+    std::atomic<Chunk*> current{nullptr};
+
+    static uint64_t prefixOf(const char* data, size_t length) {
+        uint64_t prefix = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            prefix = prefix << 8 | (i < length ? static_cast<unsigned char>(data[i]) : 0);
+        }
+        return prefix;
+    }
 
-        while (current && current != handle) {
-            Node* next = current->next;
-            if (current->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                delete current;
+    // Bump-allocates from the current chunk; only starting a chunk locks
+    const char* copy(const char* data, size_t length) {
+        Chunk* chunk = current.load(std::memory_order_acquire);
+        while (true) {
+            if (chunk) {
+                size_t at = chunk->used.fetch_add(length, std::memory_order_relaxed);
+                if (at + length <= chunk->capacity) {
+                    std::memcpy(chunk->bytes + at, data, length);
+                    return chunk->bytes + at;
+                }
+            }
+            std::lock_guard<std::mutex> lock(refill);
+            if (current.load(std::memory_order_relaxed) == chunk) {
+                size_t capacity = std::max(kChunk, length);
+                chunk = new Chunk{new char[capacity], capacity};
+                chunks.push_back(chunk);
+                current.store(chunk, std::memory_order_release);
+            } else {
+                chunk = current.load(std::memory_order_relaxed);
             }
-            current = next;
         }
+    }
+};
 
-        // Reset the head to indicate completion
-        if (slot.refCount.load(std::memory_order_acquire) == 0) {
-            slot.head.store(nullptr, std::memory_order_release);
-        }
+// How a node holds its value: not at all when V is empty, inline when it is
+// small and trivially copyable, so the copies made while rebalancing are
+// plain stores, and otherwise behind a shared pointer those copies share.
+template <class V, int Kind = std::is_empty<V>::value ? 0
+                             : sizeof(V) <= 16 && std::is_trivially_copyable<V>::value ? 1 : 2>
+struct ValueSlot {
+    ValueSlot() = default;
+    explicit ValueSlot(const V&) {}
+
+    const V& get() const {
+        static const V empty{};
+        return empty;
     }
 };
 
+template <class V>
+struct ValueSlot<V, 1> {
+    V value;
+
+    ValueSlot() : value() {}
+    explicit ValueSlot(const V& v) : value(v) {}
+    const V& get() const { return value; }
+};
+
+template <class V>
+struct ValueSlot<V, 2> {
+    std::shared_ptr<const V> value;
+
+    ValueSlot() : value(std::make_shared<const V>()) {}
+    explicit ValueSlot(const V& v) : value(std::make_shared<const V>(v)) {}
+    const V& get() const { return *value; }
+};
+
+// Value type of a BonsaiTree used as a set
+struct NoValue {};
+
+// Bonsai tree (Clements, Kaashoek, Zeldovich): a weight-balanced persistent
+// tree. Writers build a new version of the path they touch and publish it by
+// CASing the root; readers walk whatever version they loaded without any
+// synchronization, and Hyaline keeps replaced nodes alive until they leave.
+template <class K, class V = NoValue, class Compare = std::less<K>>
 class BonsaiTree {
+    using Keys = KeyPolicy<K, Compare>;
+    using Key = typename Keys::Stored;
+    using Value = ValueSlot<V>;
+
+    // Nodes are immutable once published: updates copy the path they change
+    // and swing the root with a single CAS. An empty value adds no space.
+    struct Node : HyalineNode, Value {
+        const Key key;
+        int size;                  // Number of keys in this subtree (weight)
+        Node* left;                // Left child
+        Node* right;               // Right child
+        bool fresh;                // Created by an update that has not been published yet
+
+        Node(const Key& k, const Value& v, Node* l, Node* r)
+            : Value(v), key(k), size(1 + (l ? l->size : 0) + (r ? r->size : 0)), left(l), right(r), fresh(true) {}
+
+        static void* operator new(size_t size) { return NodeArena::allocate(size); }
+        static void* operator new(size_t, NodeArena* arena, size_t index) { return arena->place(index); }
+        static void operator delete(void* p) { NodeArena::release(p); }
+        static void operator delete(void* p, NodeArena*, size_t) { NodeArena::release(p); }
+    };
+
 public:
     BonsaiTree(Hyaline& hyaline, int numSlots) : root(nullptr), hyaline(hyaline), slotCount(numSlots) {}
 
     ~BonsaiTree() {
-        deleteTree(root); // Automatically clean up the tree when the object is destroyed
+        deleteTree(root.load()); // Automatically clean up the tree when the object is destroyed
     }
 
-    void insert(int key, int slotId) {
-        Node* handle = hyaline.enter(slotId);
-        root = insertRec(root, key);
-        hyaline.leave(slotId, handle);
+    // Adds key with value unless key is already present
+    bool insert(const K& key, const V& value, int slotId) {
+        hyaline.enter(slotId);
+        std::optional<Key> interned; // At most once, and only if the key is new
+        bool inserted = update(slotId, [&](Node* current, Update& u) {
+            return insertPath(current, key, interned, value, u);
+        });
+        hyaline.leave(slotId);
+        return inserted;
     }
 
-    void remove(int key, int slotId) {
-        Node* handle = hyaline.enter(slotId);
-        root = removeRec(root, key, slotId);
-        hyaline.leave(slotId, handle);
+    bool insert(const K& key, int slotId) { return insert(key, V(), slotId); }
+
+    bool remove(const K& key, int slotId) {
+        hyaline.enter(slotId);
+        bool removed = update(slotId, [&](Node* current, Update& u) { return removePath(current, key, u); });
+        hyaline.leave(slotId);
+        return removed;
+    }
+
+    bool contains(const K& key, int slotId) {
+        hyaline.enter(slotId);
+        bool found = find(key) != nullptr;
+        hyaline.leave(slotId);
+        return found;
+    }
+
+    std::optional<V> get(const K& key, int slotId) {
+        hyaline.enter(slotId);
+        std::optional<V> value;
+        if (Node* node = find(key)) value = node->get();
+        hyaline.leave(slotId);
+        return value;
+    }
+
+    // Forward iterator over the keys >= lo of the version that was current
+    // when it was created. Published versions never change, so the scan is a
+    // consistent snapshot however long it runs; the slot stays entered until
+    // the iterator is destroyed, which keeps every node retired meanwhile
+    // from being freed.
+    //
+    // Not reentrant: Hyaline slots do not nest, so while an iterator is live
+    // its slot must not be used by a second iterator or by any other call on
+    // the tree (insert, remove, contains, get, range). Use another slot, or
+    // finish the scan first.
+    class Iterator {
+    public:
+        Iterator(BonsaiTree& tree, const K& lo, int slotId) : hyaline(tree.hyaline), slotId(slotId) {
+            hyaline.enter(slotId);
+            const Key& bound = tree.keys.probe(lo);
+            Node* node = tree.root.load(std::memory_order_acquire);
+            while (node) {
+                if (tree.keys.less(node->key, bound)) {
+                    node = node->right;
+                } else {
+                    path.push_back(node);
+                    node = node->left;
+                }
+            }
+        }
+
+        Iterator(const Iterator&) = delete;
+        Iterator& operator=(const Iterator&) = delete;
+
+        ~Iterator() { hyaline.leave(slotId); }
+
+        bool valid() const { return !path.empty(); }
+        typename Keys::View key() const { return Keys::view(path.back()->key); }
+        const V& value() const { return path.back()->get(); }
+
+        void next() {
+            Node* node = path.back()->right;
+            path.pop_back();
+            for (; node; node = node->left) path.push_back(node);
+        }
+
+    private:
+        friend class BonsaiTree;
+
+        Hyaline& hyaline;
+        const int slotId;
+        std::vector<Node*> path; // Ancestors still to visit, the current node last
+    };
+
+    Iterator seek(const K& lo, int slotId) { return Iterator(*this, lo, slotId); }
+
+    // Calls visit(key) for every key in [lo, hi], in order, from one version.
+    // The scan runs on an Iterator, so visit must not use the tree with the
+    // same slot.
+    template <class Callback>
+    void range(const K& lo, const K& hi, Callback visit, int slotId) {
+        const Key& bound = keys.probe(hi);
+        for (Iterator it(*this, lo, slotId); it.valid() && !keys.less(bound, it.path.back()->key); it.next()) {
+            visit(it.key());
+        }
+    }
+
+    // Builds a perfectly balanced tree over [first, last), which must be
+    // strictly increasing, and publishes it if the tree is still empty.
+    // Node i holds the i-th key, with a default value, and sits in slot i of
+    // one arena, so subtrees are built bottom-up by up to `workers` threads
+    // with no shared allocator, and a scan of the loaded tree walks memory
+    // in order.
+    template <class Iter>
+    bool bulkLoad(Iter first, Iter last, int workers) {
+        size_t count = last - first;
+        if (count == 0) return true;
+        if (root.load(std::memory_order_acquire)) return false;
+        NodeArena* arena = new NodeArena(count, sizeof(Node));
+        int spawn = 0;
+        while ((1 << spawn) < workers) ++spawn;
+        Node* top = build(arena, first, 0, count, spawn);
+        Node* expected = nullptr;
+        if (root.compare_exchange_strong(expected, top, std::memory_order_acq_rel)) return true;
+        // Lost to a concurrent update; nothing else has seen these nodes
+        for (size_t i = 0; i < count; ++i) {
+            delete static_cast<Node*>(arena->node(i));
+        }
+        return false;
     }
 
     void printInOrder() const {
-        printRec(root);
+        std::vector<Node*> path;
+        for (Node* node = root.load(); node || !path.empty();) {
+            if (node) {
+                path.push_back(node);
+                node = node->left;
+                continue;
+            }
+            node = path.back();
+            path.pop_back();
+            std::cout << Keys::view(node->key) << " ";
+            node = node->right;
+        }
         std::cout << std::endl;
     }
 
 private:
-    Node* root;
+    static constexpr int kDelta = 3; // Max weight ratio between siblings
+    static constexpr int kRatio = 2; // Picks single vs double rotation
+
+    // Weight balance keeps the height under log base 4/3 of the size, about
+    // 75 for 2^31 keys
+    static constexpr int kMaxHeight = 96;
+
+    // Ancestors visited by a descent, root first, and the side taken at each
+    struct Path {
+        Node* nodes[kMaxHeight];
+        bool wentLeft[kMaxHeight];
+        int depth = 0;
+    };
+
+    // Nodes created and replaced by one update attempt
+    struct Update {
+        std::vector<Node*> created;
+        std::vector<Node*> superseded; // Created, then replaced again before publishing
+        std::vector<Node*> replaced;   // Published nodes the new version no longer uses
+    };
+
+    std::atomic<Node*> root;
     Hyaline& hyaline;
     const int slotCount;
+    Keys keys;
+
+    // Build a new version from the current root and try to publish it. The
+    // replaced nodes of a successful attempt are retired as one batch; a failed
+    // attempt never published anything, so its nodes are freed right away.
+    template <class Build>
+    bool update(int slotId, Build build) {
+        Update u;
+        while (true) {
+            Node* current = root.load(std::memory_order_acquire);
+            Node* next = build(current, u);
+            if (next == current) return false; // Nothing to change
+
+            for (Node* node : u.created) {
+                if (node->fresh) {
+                    node->fresh = false; // Part of the new version
+                } else {
+                    u.superseded.push_back(node);
+                }
+            }
+            if (root.compare_exchange_strong(current, next, std::memory_order_acq_rel)) {
+                for (Node* node : u.superseded) {
+                    delete node;
+                }
+                retireBatch(u.replaced, slotId);
+                return true;
+            }
+            for (Node* node : u.created) {
+                delete node;
+            }
+            u.created.clear();
+            u.superseded.clear();
+            u.replaced.clear();
+        }
+    }
+
+    void retireBatch(const std::vector<Node*>& nodes, int slotId) {
+        if (nodes.empty()) return;
+        for (size_t i = 0; i + 1 < nodes.size(); ++i) {
+            nodes[i]->batchNext = nodes[i + 1];
+        }
+        nodes.back()->batchNext = nullptr;
+        hyaline.retire(nodes.front(), slotId);
+    }
+
+    // Each level splits the range at its middle key; the top spawn levels
+    // hand their left half to a new thread
+    template <class Iter>
+    Node* build(NodeArena* arena, Iter first, size_t lo, size_t hi, int spawn) {
+        if (lo == hi) return nullptr;
+        size_t mid = lo + (hi - lo) / 2;
+        Node* left;
+        Node* right;
+        if (spawn > 0) {
+            std::thread helper([&]() { left = build(arena, first, lo, mid, spawn - 1); });
+            right = build(arena, first, mid + 1, hi, spawn - 1);
+            helper.join();
+        } else {
+            left = build(arena, first, lo, mid, 0);
+            right = build(arena, first, mid + 1, hi, 0);
+        }
+        Node* node = new (arena, mid) Node(keys.intern(first[mid]), Value(), left, right);
+        node->fresh = false;
+        return node;
+    }
 
     void deleteTree(Node* node) {
-        if (!node) return;
-        deleteTree(node->left);
-        deleteTree(node->right);
-        delete node;
-    }
-
-    Node* insertRec(Node* node, int key) {
-        if (!node) return new Node(key);
-        if (key < node->key)
-            node->left = insertRec(node->left, key);
-        else if (key > node->key)
-            node->right = insertRec(node->right, key);
+        std::vector<Node*> pending;
+        if (node) pending.push_back(node);
+        while (!pending.empty()) {
+            node = pending.back();
+            pending.pop_back();
+            if (node->left) pending.push_back(node->left);
+            if (node->right) pending.push_back(node->right);
+            delete node;
+        }
+    }
+
+    static int size(Node* node) { return node ? node->size : 0; }
+
+    static Node* make(const Key& key, const Value& value, Node* left, Node* right, Update& u) {
+        Node* node = new Node(key, value, left, right);
+        u.created.push_back(node);
         return node;
     }
 
-    Node* removeRec(Node* node, int key, int slotId) {
-        if (!node) return nullptr;
-
-        if (key < node->key)
-            node->left = removeRec(node->left, key, slotId);
-        else if (key > node->key)
-            node->right = removeRec(node->right, key, slotId);
-        else {
-            if (!node->left) {
-                Node* rightChild = node->right;
-                hyaline.retire(node, slotId);
-                return rightChild;
-            } else if (!node->right) {
-                Node* leftChild = node->left;
-                hyaline.retire(node, slotId);
-                return leftChild;
-            }
+    // A copy of from's key and value over new children
+    static Node* make(const Node* from, Node* left, Node* right, Update& u) {
+        return make(from->key, *from, left, right, u);
+    }
+
+    // The caller is building a replacement for node
+    static void replace(Node* node, Update& u) {
+        if (node->fresh) {
+            node->fresh = false; // Created and superseded within this attempt
+        } else {
+            u.replaced.push_back(node);
+        }
+    }
+
+    // Rotations copy whole entries, so from is the node whose key and value
+    // go between left and right; it stays allocated for the whole attempt
+    static Node* balance(const Node* from, Node* left, Node* right, Update& u) {
+        int sl = size(left), sr = size(right);
+        if (sl + sr <= 1) return make(from, left, right, u);
+        if (sr > kDelta * sl) return rotateLeft(from, left, right, u);
+        if (sl > kDelta * sr) return rotateRight(from, left, right, u);
+        return make(from, left, right, u);
+    }
 
-            Node* successor = minValueNode(node->right);
-            node->key = successor->key;
-            node->right = removeRec(node->right, successor->key, slotId);
+    static Node* rotateLeft(const Node* from, Node* left, Node* right, Update& u) {
+        replace(right, u);
+        Node* rl = right->left;
+        if (size(rl) < kRatio * size(right->right)) {
+            return make(right, make(from, left, rl, u), right->right, u);
+        }
+        replace(rl, u);
+        return make(rl, make(from, left, rl->left, u), make(right, rl->right, right->right, u), u);
+    }
+
+    static Node* rotateRight(const Node* from, Node* left, Node* right, Update& u) {
+        replace(left, u);
+        Node* lr = left->right;
+        if (size(lr) < kRatio * size(left->left)) {
+            return make(left, left->left, make(from, lr, right, u), u);
+        }
+        replace(lr, u);
+        return make(lr, make(left, left->left, lr->left, u), make(from, lr->right, right, u), u);
+    }
+
+    Node* find(const K& key) const {
+        const Key& probe = keys.probe(key);
+        Node* node = root.load(std::memory_order_acquire);
+        while (node) {
+            __builtin_prefetch(node->left);
+            __builtin_prefetch(node->right);
+            // Both compares, no short circuit, so the step is a conditional
+            // move rather than a branch on the key
+            bool goLeft = keys.less(probe, node->key);
+            if (!(goLeft | keys.less(node->key, probe))) break;
+            node = goLeft ? node->left : node->right;
+        }
+        return node;
+    }
+
+    // Descends from node towards key, recording the path, and returns where
+    // it stopped: the node holding key, or null. Both children are
+    // prefetched before the key compare, so the next level's miss is already
+    // in flight whichever way the walk turns.
+    Node* descend(Node* node, const Key& key, Path& path) const {
+        path.depth = 0;
+        while (node) {
+            __builtin_prefetch(node->left);
+            __builtin_prefetch(node->right);
+            bool goLeft = keys.less(key, node->key);
+            if (!goLeft && !keys.less(node->key, key)) break;
+            path.nodes[path.depth] = node;
+            path.wentLeft[path.depth++] = goLeft;
+            node = goLeft ? node->left : node->right;
         }
         return node;
     }
 
-    Node* minValueNode(Node* node) const {
-        Node* current = node;
-        while (current && current->left)
-            current = current->left;
-        return current;
+    // Replaces each node on the path, bottom-up, with a rebalanced copy
+    // whose child along the path is child
+    static Node* rebuild(const Path& path, Node* child, Update& u) {
+        for (int i = path.depth - 1; i >= 0; --i) {
+            Node* node = path.nodes[i];
+            replace(node, u);
+            child = path.wentLeft[i] ? balance(node, child, node->right, u)
+                                     : balance(node, node->left, child, u);
+        }
+        return child;
+    }
+
+    Node* insertPath(Node* root, const K& key, std::optional<Key>& interned, const V& value, Update& u) {
+        Path path;
+        if (descend(root, keys.probe(key), path)) return root; // Already present
+        if (!interned) interned = keys.intern(key);
+        return rebuild(path, make(*interned, Value(value), nullptr, nullptr, u), u);
+    }
+
+    Node* removePath(Node* root, const K& key, Update& u) {
+        Path path;
+        Node* node = descend(root, keys.probe(key), path);
+        if (!node) return root;
+        replace(node, u);
+        return rebuild(path, glue(node->left, node->right, u), u);
+    }
+
+    // Join two subtrees whose keys are ordered, borrowing from the heavier side
+    Node* glue(Node* left, Node* right, Update& u) {
+        if (!left) return right;
+        if (!right) return left;
+        Node* top;
+        if (left->size > right->size) {
+            left = removeExtreme(left, false, top, u);
+            return balance(top, left, right, u);
+        }
+        right = removeExtreme(right, true, top, u);
+        return balance(top, left, right, u);
     }
 
-    void printRec(Node* node) const {
-        if (!node) return;
-        printRec(node->left);
-        std::cout << node->key << " ";
-        printRec(node->right);
+    // Unlinks the smallest (min) or largest node of node's subtree into extreme
+    Node* removeExtreme(Node* node, bool min, Node*& extreme, Update& u) {
+        Path path;
+        for (path.depth = 0;; ++path.depth) {
+            replace(node, u);
+            Node* next = min ? node->left : node->right;
+            if (!next) break;
+            __builtin_prefetch(min ? next->left : next->right);
+            path.nodes[path.depth] = node;
+            path.wentLeft[path.depth] = min;
+            node = next;
+        }
+        extreme = node;
+        Node* child = min ? node->right : node->left;
+        // The path nodes were already replaced on the way down
+        for (int i = path.depth - 1; i >= 0; --i) {
+            Node* n = path.nodes[i];
+            child = min ? balance(n, child, n->right, u) : balance(n, n->left, child, u);
+        }
+        return child;
     }
 };
 
+// Single-threaded cost of each operation on a large tree: keys 0, 2, 4, ...
+// are bulk-loaded, then random hits, misses, inserts of odd keys and their
+// removal are timed separately. Random keys make most levels of each walk a
+// cache miss, which is what the prefetching descent targets.
+void microbench(Hyaline& hyaline, long keys, int workers) {
+    BonsaiTree<int> tree(hyaline, 1);
+    std::vector<int> sorted(keys);
+    for (long k = 0; k < keys; ++k) sorted[k] = static_cast<int>(2 * k);
+    tree.bulkLoad(sorted.begin(), sorted.end(), workers);
+
+    const int ops = 1000000;
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<long> dis(0, keys - 1);
+    std::vector<int> hits(ops), misses(ops);
+    for (int i = 0; i < ops; ++i) {
+        hits[i] = static_cast<int>(2 * dis(gen));
+        misses[i] = static_cast<int>(2 * dis(gen) + 1);
+    }
+
+    auto time = [&](const char* name, auto op) {
+        auto start = std::chrono::high_resolution_clock::now();
+        long done = 0;
+        for (int i = 0; i < ops; ++i) done += op(i);
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::high_resolution_clock::now() - start;
+        std::cout << name << ": " << elapsed.count() / ops << " ns/op (" << done << " succeeded)" << std::endl;
+    };
+    std::cout << "Tree: " << keys << " keys" << std::endl;
+    time("contains hit", [&](int i) { return tree.contains(hits[i], 0); });
+    time("contains miss", [&](int i) { return tree.contains(misses[i], 0); });
+    time("insert", [&](int i) { return tree.insert(misses[i], 0); });
+    time("remove", [&](int i) { return tree.remove(misses[i], 0); });
+}
+
+// The workload above on string keys with 8-byte values, shaped like
+// metadata: a hashed id followed by a longer attribute path, so most
+// comparisons are decided by the cached prefix. Each thread inserts, reads
+// back and every third time removes a key, then the tree's keys are counted
+// with a full scan.
+void stringKeyBench(Hyaline& hyaline, int threads, int objects) {
+    BonsaiTree<std::string, uint64_t> tree(hyaline, threads);
+    std::vector<std::string> names(objects);
+    for (int k = 0; k < objects; ++k) {
+        char id[17];
+        std::snprintf(id, sizeof(id), "%016llx", static_cast<unsigned long long>(std::hash<int>()(k) * 0x9e3779b97f4a7c15ull));
+        names[k] = std::string(id) + "/attributes/owner/" + std::to_string(k);
+    }
+
+    std::vector<std::thread> workers;
+    std::atomic<long> found{0};
+    std::atomic<long> executed{0};
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            std::mt19937 gen(i + 1);
+            std::uniform_int_distribution<> dis(0, objects - 1);
+            long hits = 0;
+            long ops = 0;
+            for (int j = 0; j < objects / threads; ++j) {
+                int k = dis(gen);
+                tree.insert(names[k], k, i);
+                if (tree.get(names[dis(gen)], i)) ++hits;
+                ops += 2;
+                if (j % 3 == 0) {
+                    tree.remove(names[k], i);
+                    ++ops;
+                }
+            }
+            found += hits;
+            executed += ops;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start_time;
+    long keys = 0;
+    for (auto it = tree.seek(std::string(), 0); it.valid(); it.next()) ++keys;
+    std::cout << "String keys | Threads: " << threads << " | Throughput: " << executed.load() / elapsed.count()
+              << " ops/sec | Gets found: " << found << " | Keys left: " << keys << std::endl;
+}
+
 int main(int argc, char* argv[]) {
     int threads;
-    if (argc == 2) {
+    if (argc >= 2) {
         threads = std::stoi(argv[1]);
     }
     else {
         threads = 4;
     }
+    bool background = false;
+    long budget = 0;
+    int scanLength = 0;
+    long load = 0;
+    long micro = 0;
+    bool stringKeys = false;
+    for (int a = 2; a < argc; ++a) {
+        std::string option = argv[a];
+        if (option == "background") background = true;
+        else if (option.rfind("budget=", 0) == 0) budget = std::stol(option.substr(7));
+        else if (option.rfind("scan=", 0) == 0) scanLength = std::stoi(option.substr(5));
+        else if (option.rfind("load=", 0) == 0) load = std::stol(option.substr(5));
+        else if (option.rfind("micro=", 0) == 0) micro = std::stol(option.substr(6));
+        else if (option == "keys=string") stringKeys = true;
+    }
     std::cout << "The thread count is: " << threads << std::endl;
+    if (background) std::cout << "Reclamation: background thread" << std::endl;
+    if (micro > 0) {
+        Hyaline hyaline(threads, background);
+        microbench(hyaline, micro, threads);
+        return 0;
+    }
     const int objects = 10000; // Number of objects to operate on
+    if (stringKeys) {
+        Hyaline hyaline(threads, background);
+        hyaline.setBudget(budget);
+        stringKeyBench(hyaline, threads, objects);
+        return 0;
+    }
     auto start_time = std::chrono::high_resolution_clock::now();
-    Hyaline hyaline(threads);
-    BonsaiTree tree(hyaline, threads);
+    Hyaline hyaline(threads, background);
+    hyaline.setBudget(budget);
+    BonsaiTree<int> tree(hyaline, threads);
+    if (load > 0) {
+        // Every other key, so the workload below both adds and removes
+        std::vector<int> keys(load);
+        for (long k = 0; k < load; ++k) keys[k] = static_cast<int>(2 * k);
+        auto load_start = std::chrono::high_resolution_clock::now();
+        tree.bulkLoad(keys.begin(), keys.end(), threads);
+        std::chrono::duration<double> loaded = std::chrono::high_resolution_clock::now() - load_start;
+        std::cout << "Bulk load: " << load << " keys in " << loaded.count() << " s | "
+                  << load / loaded.count() << " keys/sec" << std::endl;
+        start_time = std::chrono::high_resolution_clock::now();
+    }
 
     std::vector<std::thread> workers;
+    std::atomic<long> peakUnreclaimed{0};
 
     for (int i = 0; i < threads; ++i) {
-        workers.emplace_back([&tree, i, objects, threads]() {
+        workers.emplace_back([&tree, &hyaline, &peakUnreclaimed, i, objects, threads, scanLength]() {
             std::random_device rd;
             std::mt19937 gen(rd());
             std::uniform_int_distribution<> dis(1, objects);
+            long peak = 0, visited = 0;
 
             for (int j = 0; j < objects / threads; ++j) {
                 int key = dis(gen);
                 tree.insert(key, i);
                 if (j % 3 == 0) tree.remove(key, i);
+                if (scanLength > 0) {
+                    // Sampled inside the scan, while its slot holds back reclamation
+                    tree.range(key, key + scanLength, [&](int) {
+                        if (++visited % 16 == 0) peak = std::max(peak, hyaline.unreclaimedNodes());
+                    }, i);
+                }
+            }
+            long seen = peakUnreclaimed.load();
+            while (peak > seen && !peakUnreclaimed.compare_exchange_weak(seen, peak)) {
             }
         });
     }
@@ -200,18 +793,17 @@ int main(int argc, char* argv[]) {
         worker.join();
     }
 
-    // Clean up Hyaline slots
-    for (int i = 0; i < threads; ++i) {
-        while (true) {
-            Node* handle = hyaline.enter(i);
-            if (!handle) break; // Slot fully cleaned
-            hyaline.leave(i, handle);
-        }
-    }
-
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end_time - start_time;
     double throughput = static_cast<double>(objects) / elapsed.count();
     std::cout << "Threads: " << threads << " | Throughput: " << throughput << " ops/sec" << std::endl;
+    if (scanLength > 0) {
+        std::cout << "Scan length: " << scanLength << " keys | Peak unreclaimed: " << peakUnreclaimed << " nodes"
+                  << std::endl;
+    }
+    if (budget > 0) {
+        std::cout << "Budget: " << budget << " nodes | Pressure scans: " << hyaline.pressureScans()
+                  << " | Stalls: " << hyaline.pressureStalls() << std::endl;
+    }
     return 0;
 }
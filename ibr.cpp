@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <atomic>
 #include <thread>
@@ -7,151 +8,161 @@
 #include <list>
 #include <unordered_map>
 #include <random>
+#include <string>
 
-// Memory management API for IBR
-class IBRManager {
-public:
-    struct Node {
-        int value;
-        std::atomic<Node*> left{nullptr};
-        std::atomic<Node*> right{nullptr};
-        std::atomic<int> birth_epoch{0};
-        std::atomic<int> retire_epoch{-1};
-    };
-
-    static std::atomic<int> global_epoch;
-    thread_local static int local_epoch;
-    thread_local static std::list<Node*> retired_nodes;
-
-    static void start_op() {
-        local_epoch = global_epoch.load();
-    }
-
-    static void end_op() {
-        local_epoch = -1;  // Reset epoch
-    }
-
-    static Node* allocate_node(int value) {
-        Node* node = new Node();
-        node->value = value;
-        node->birth_epoch = global_epoch.load();
-        return node;
-    }
-
-    static void retire_node(Node* node) {
-        node->retire_epoch = global_epoch.load();
-        retired_nodes.push_back(node);
-        clean_up();
-    }
-
-    static void clean_up() {
-        for (auto it = retired_nodes.begin(); it != retired_nodes.end();) {
-            Node* node = *it;
-            if (node->retire_epoch.load() < get_min_active_epoch()) {
-                delete node;  // Free memory
-                it = retired_nodes.erase(it);  // Remove from list
-            } else {
-                ++it;
-            }
-        }
-    }
+#include "ibr_manager.h"
 
-    static void final_clean_up() {
-        for (auto node : retired_nodes) {
-            delete node;
-        }
-        retired_nodes.clear();
-    }
+struct Node : IBRNode {
+    int value;
+    std::atomic<Node*> left{nullptr};
+    std::atomic<Node*> right{nullptr};
+    std::atomic<bool> removed{false}; // Logically deleted; unlinked once it has no children
 
-
-private:
-    static int get_min_active_epoch() {
-        // Placeholder for the actual implementation to find the minimum active epoch.
-        return global_epoch.load() - 2;  // Example heuristic.
-    }
+    Node(int v) : value(v) {}
 };
 
-std::atomic<int> IBRManager::global_epoch{0};
-thread_local int IBRManager::local_epoch = -1;
-thread_local std::list<IBRManager::Node*> IBRManager::retired_nodes;
-
 // Lock-free Bonsai Tree Implementation
 class BonsaiTree {
 public:
     BonsaiTree() {
-        root = IBRManager::allocate_node(-1);  // Dummy root node
+        root = IBRManager::allocate_node<Node>(-1);  // Dummy root node
+    }
+
+    // Frees the nodes still linked in; unlinked ones belong to IBRManager
+    ~BonsaiTree() {
+        std::vector<Node*> pending{root};
+        while (!pending.empty()) {
+            Node* node = pending.back();
+            pending.pop_back();
+            if (Node* left = child(node->left)) pending.push_back(left);
+            if (Node* right = child(node->right)) pending.push_back(right);
+            delete node;
+        }
     }
 
     void insert(int value) {
         IBRManager::start_op();
-        Node* new_node = IBRManager::allocate_node(value);
+        Node* new_node = IBRManager::allocate_node<Node>(value);
         Node* current = root;
 
         while (true) {
-            if (value < current->value) {
-                Node* left = current->left.load();
-                if (!left) {
-                    if (current->left.compare_exchange_weak(left, new_node)) {
-                        break;
-                    }
-                } else {
-                    current = left;
+            std::atomic<Node*>& link = value < current->value ? current->left : current->right;
+            Node* child = link.load();
+            if (child == frozen()) {
+                current = root;  // current is being unlinked; search again
+            } else if (!child) {
+                if (link.compare_exchange_weak(child, new_node)) {
+                    break;
                 }
             } else {
-                Node* right = current->right.load();
-                if (!right) {
-                    if (current->right.compare_exchange_weak(right, new_node)) {
-                        break;
-                    }
-                } else {
-                    current = right;
-                }
+                current = child;
             }
         }
         IBRManager::end_op();
     }
 
+    // Removes one copy of value. Setting the removed flag decides between
+    // concurrent removers. The winner unlinks the node only if it is a leaf;
+    // otherwise it stays as a routing node, and whoever removes its last
+    // child unlinks it then.
     void remove(int value) {
         IBRManager::start_op();
-        Node* parent = nullptr;
+        std::vector<std::pair<Node*, bool>> path;  // Ancestors, and whether the walk went left
         Node* current = root;
-        bool is_left_child = false;
 
-        while (current && current->value != value) {
-            parent = current;
-            if (value < current->value) {
-                current = current->left.load();
-                is_left_child = true;
-            } else {
-                current = current->right.load();
-                is_left_child = false;
-            }
-        }
+        do {
+            bool go_left = value < current->value;
+            path.emplace_back(current, go_left);
+            current = child(go_left ? current->left : current->right);
+        } while (current && (current->value != value || current->removed.exchange(true)));
 
         if (!current) {
             IBRManager::end_op();
             return;  // Value not found
         }
 
-        IBRManager::retire_node(current);
-        if (is_left_child) {
-            parent->left.store(nullptr);
-        } else {
-            parent->right.store(nullptr);
+        while (unlink(path.back().first, path.back().second, current)) {
+            current = path.back().first;
+            path.pop_back();
+            if (current == root || !current->removed.load()) break;
         }
 
         IBRManager::end_op();
     }
 
+    // Calls visit(value) for every value in [lo, hi], in order. The whole walk
+    // is one operation, so its reservation holds back every node retired
+    // while it runs.
+    template <class Callback>
+    void range(int lo, int hi, Callback visit) {
+        IBRManager::start_op();
+        std::vector<Node*> path;
+        Node* current = child(root->right);
+        while (current || !path.empty()) {
+            if (current) {
+                if (current->value < lo) {
+                    current = child(current->right);
+                } else {
+                    path.push_back(current);
+                    current = child(current->left);
+                }
+                continue;
+            }
+            current = path.back();
+            path.pop_back();
+            if (current->value > hi) break;
+            if (!current->removed.load()) visit(current->value);
+            current = child(current->right);
+        }
+        IBRManager::end_op();
+    }
+
 private:
-    using Node = IBRManager::Node;
     Node* root;
+
+    // Marks the child links of a node that is being unlinked
+    static Node* frozen() {
+        static Node sentinel(0);
+        return &sentinel;
+    }
+
+    static Node* child(const std::atomic<Node*>& link) {
+        Node* node = link.load();
+        return node == frozen() ? nullptr : node;
+    }
+
+    // Freezes both child links of a removed leaf, so no insert can attach
+    // below it, then swings the parent's link past it. Only the thread whose
+    // CAS froze the left link gets this far, so each node is unlinked and
+    // retired once, and only after it is unreachable.
+    bool unlink(Node* parent, bool left_side, Node* node) {
+        while (true) {
+            Node* expected = nullptr;
+            if (!node->left.compare_exchange_strong(expected, frozen())) return false;
+            expected = nullptr;
+            if (node->right.compare_exchange_strong(expected, frozen())) break;
+            node->left.store(nullptr);
+            // A thread that emptied the right subtree meanwhile saw our frozen
+            // left link and left the unlink to us
+            if (node->right.load()) return false;
+        }
+        Node* expected = node;
+        std::atomic<Node*>& link = left_side ? parent->left : parent->right;
+        if (!link.compare_exchange_strong(expected, nullptr)) {
+            node->right.store(nullptr);
+            node->left.store(nullptr);
+            return false;
+        }
+        IBRManager::retire_node(node);
+        return true;
+    }
 };
 
 // Benchmarking
-void benchmark(int thread_count, int total_operations) {
+void benchmark(int thread_count, int total_operations, int scan_length) {
     BonsaiTree tree;
     std::atomic<int> operation_count{0};
+    std::atomic<long> peak_unreclaimed{0};
     std::vector<std::thread> threads;
     auto start_time = std::chrono::high_resolution_clock::now();
 
@@ -159,11 +170,22 @@ void benchmark(int thread_count, int total_operations) {
         threads.emplace_back([&]() {
             std::mt19937 rng(std::random_device{}());
             std::uniform_int_distribution<int> dist(0, 1000);
+            long peak = 0, visited = 0;
 
             while (operation_count.load() < total_operations) {
                 tree.insert(dist(rng));
                 tree.remove(dist(rng));
                 operation_count.fetch_add(2);
+                if (scan_length > 0) {
+                    // Sampled inside the scan, while its reservation holds back reclamation
+                    int lo = dist(rng);
+                    tree.range(lo, lo + scan_length, [&](int) {
+                        if (++visited % 16 == 0) peak = std::max(peak, IBRManager::unreclaimed.load());
+                    });
+                }
+            }
+            long seen = peak_unreclaimed.load();
+            while (peak > seen && !peak_unreclaimed.compare_exchange_weak(seen, peak)) {
             }
         });
     }
@@ -176,21 +198,45 @@ void benchmark(int thread_count, int total_operations) {
     std::chrono::duration<double> elapsed = end_time - start_time;
     double throughput = static_cast<double>(total_operations) / elapsed.count();
     std::cout << "Threads: " << thread_count << " | Throughput: " << throughput << " ops/sec" << std::endl;
+    if (scan_length > 0) {
+        std::cout << "Scan length: " << scan_length << " keys | Peak unreclaimed: " << peak_unreclaimed
+                  << " nodes" << std::endl;
+    }
 }
 
 int main(int argc, char* argv[]) {
     int thread_count;
-    if (argc == 2) {
+    if (argc >= 2) {
         thread_count = std::stoi(argv[1]);
     }
     else {
         thread_count = 4;
     }
+    bool background = false;
+    long budget = 0;
+    int scan_length = 0;
+    for (int a = 2; a < argc; ++a) {
+        std::string option = argv[a];
+        if (option == "background") background = true;
+        else if (option.rfind("budget=", 0) == 0) budget = std::stol(option.substr(7));
+        else if (option.rfind("scan=", 0) == 0) scan_length = std::stoi(option.substr(5));
+    }
     std::cout << "The thread count is: " << thread_count << std::endl;
+    IBRManager::set_unreclaimed_budget(budget);
+    if (background) {
+        std::cout << "Reclamation: background thread" << std::endl;
+        IBRManager::start_background_reclaimer();
+    }
     
     int total_operations = 10000; // Define total number of operations
 
-    benchmark(thread_count, total_operations);
+    benchmark(thread_count, total_operations, scan_length);
+    if (background) IBRManager::stop_background_reclaimer();
+    if (budget > 0) {
+        std::cout << "Budget: " << budget << " nodes | Pressure scans: " << IBRManager::pressure_scans
+                  << " | Epoch advances: " << IBRManager::pressure_epoch_advances
+                  << " | Stalls: " << IBRManager::pressure_stalls << std::endl;
+    }
 
     // Final clean-up of any residual retired nodes
     IBRManager::final_clean_up();
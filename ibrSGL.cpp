@@ -1,127 +1,306 @@
 #include <iostream>
-#include <unordered_map>
 #include <atomic>
 #include <thread>
 #include <vector>
 #include <chrono>
 #include <random>
+#include <string>
 #include <list>
 #include <mutex>
+#include <optional>
 
-class IBRManager {
-public:
-    struct Node {
-        int key;
-        int value;
-        std::atomic<int> birth_epoch;
-        std::atomic<int> retire_epoch;
+#include "flat_combining.h"
+#include "ibr_manager.h"
+#include "michael_hashmap.h"
+#include "reclaimer.h"
+#include "sharded_map.h"
+#include "split_ordered_map.h"
+
+struct Node : IBRNode {
+    int key;
+    int value;
+    std::atomic<Node*> next{nullptr};
+
+    Node(int k, int v) : key(k), value(v) {}
+};
+
+// How find reaches the table: under the mutex, by a plain lock-free walk, or
+// by a walk that retries if any write overlapped it (seqlock)
+enum class FindMode { Locked, LockFree, Seqlock };
+
+const char* find_mode_name(FindMode mode) {
+    return mode == FindMode::Locked ? "locked" : mode == FindMode::LockFree ? "lock-free" : "seqlock";
+}
 
-        Node(int k, int v) : key(k), value(v), birth_epoch(0), retire_epoch(-1) {}
+// Writers serialize on one mutex and publish nodes through atomic bucket
+// pointers. With lock-free or seqlock finds, readers skip the mutex and walk
+// the chains inside an IBR operation instead, which is why replaced and
+// removed nodes (and outgrown tables) are retired rather than freed.
+class SGLUnorderedMap {
+private:
+    struct Table : IBRNode {
+        const size_t mask;
+        std::atomic<Node*>* const buckets;
+        size_t count = 0; // Only touched under the lock
+
+        explicit Table(size_t size) : mask(size - 1), buckets(new std::atomic<Node*>[size]()) {}
+        ~Table() { delete[] buckets; }
     };
 
-    static std::atomic<int> global_epoch;
-    thread_local static int local_epoch;
-    thread_local static std::list<Node*> retired_nodes;
+    // Holds the sequence count odd for the length of a write, so a seqlock
+    // find can tell that it overlapped one
+    struct WriteSection {
+        std::atomic<uint64_t>& seq;
 
-    static void start_op() {
-        local_epoch = global_epoch.load();
-    }
+        explicit WriteSection(std::atomic<uint64_t>& seq) : seq(seq) {
+            seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        ~WriteSection() { seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+    };
 
-    static void end_op() {
-        local_epoch = -1;
-    }
+    std::atomic<Table*> table{IBRManager::allocate_node<Table>(16)};
+    std::mutex global_lock;
+    alignas(64) std::atomic<uint64_t> seq{0};
+    const FindMode find_mode;
 
-    static void retire_node(Node* node) {
-        node->retire_epoch = global_epoch.load();
-        retired_nodes.push_back(node);
-        clean_up();
-    }
+    static std::atomic<Node*>& bucket(Table* t, int key) { return t->buckets[std::hash<int>()(key) & t->mask]; }
 
-    static void clean_up() {
-        for (auto it = retired_nodes.begin(); it != retired_nodes.end();) {
-            Node* node = *it;
-            if (node->retire_epoch < get_min_active_epoch()) {
-                delete node;
-                it = retired_nodes.erase(it);
-            } else {
-                ++it;
-            }
+    // The link pointing at key's node, or at the null ending its chain
+    static std::atomic<Node*>* find_link(Table* t, int key) {
+        std::atomic<Node*>* link = &bucket(t, key);
+        Node* node;
+        while ((node = link->load(std::memory_order_relaxed)) && node->key != key) {
+            link = &node->next;
         }
+        return link;
     }
 
-private:
-    static int get_min_active_epoch() {
-        // Placeholder for finding the minimum active epoch.
-        return global_epoch.load() - 2; // Example heuristic
+    // Copies every node into a table twice the size, then retires the old
+    // table and nodes, which lock-free readers may still be walking
+    void grow() {
+        Table* old = table.load(std::memory_order_relaxed);
+        Table* bigger = IBRManager::allocate_node<Table>((old->mask + 1) * 2);
+        for (size_t b = 0; b <= old->mask; ++b) {
+            for (Node* n = old->buckets[b].load(std::memory_order_relaxed); n; n = n->next.load(std::memory_order_relaxed)) {
+                Node* copy = IBRManager::allocate_node<Node>(n->key, n->value);
+                copy->next.store(bucket(bigger, n->key).load(std::memory_order_relaxed), std::memory_order_relaxed);
+                bucket(bigger, n->key).store(copy, std::memory_order_relaxed);
+            }
+        }
+        bigger->count = old->count;
+        table.store(bigger, std::memory_order_release);
+        for (size_t b = 0; b <= old->mask; ++b) {
+            for (Node* n = old->buckets[b].load(std::memory_order_relaxed); n;) {
+                Node* next = n->next.load(std::memory_order_relaxed);
+                IBRManager::retire_node(n);
+                n = next;
+            }
+        }
+        IBRManager::retire_node(old);
     }
-};
 
-std::atomic<int> IBRManager::global_epoch{0};
-thread_local int IBRManager::local_epoch = -1;
-thread_local std::list<IBRManager::Node*> IBRManager::retired_nodes;
+public:
+    explicit SGLUnorderedMap(FindMode find_mode = FindMode::Locked) : find_mode(find_mode) {}
 
-class SGLUnorderedMap {
-private:
-    std::unordered_map<int, IBRManager::Node*> map;
-    std::mutex global_lock;
+    ~SGLUnorderedMap() {
+        Table* t = table.load();
+        for (size_t b = 0; b <= t->mask; ++b) {
+            for (Node* n = t->buckets[b].load(); n;) {
+                Node* next = n->next.load();
+                delete n;
+                n = next;
+            }
+        }
+        delete t;
+    }
 
-public:
     void insert(int key, int value) {
+        IBRManager::DeferPressure defer; // Outlives the lock below
         IBRManager::start_op();
         std::lock_guard<std::mutex> lock(global_lock);
+        WriteSection write(seq);
 
-        auto it = map.find(key);
-        if (it != map.end()) {
-            IBRManager::retire_node(it->second);
-        }
-
-        map[key] = new IBRManager::Node(key, value);
-        map[key]->birth_epoch = IBRManager::global_epoch.load();
+        put_locked(key, value);
         IBRManager::end_op();
     }
 
     bool remove(int key) {
+        IBRManager::DeferPressure defer; // Outlives the lock below
         IBRManager::start_op();
         std::lock_guard<std::mutex> lock(global_lock);
+        WriteSection write(seq);
+
+        bool removed = remove_locked(key);
+        IBRManager::end_op();
+        return removed;
+    }
 
-        auto it = map.find(key);
-        if (it != map.end()) {
-            IBRManager::retire_node(it->second);
-            map.erase(it);
+    bool find(int key) {
+        IBRManager::DeferPressure defer; // Outlives the lock below
+        IBRManager::start_op();
+        if (find_mode == FindMode::Locked) {
+            std::lock_guard<std::mutex> lock(global_lock);
+
+            bool found = find_link(table.load(std::memory_order_relaxed), key)->load(std::memory_order_relaxed) != nullptr;
             IBRManager::end_op();
-            return true;
+            return found;
         }
+        bool found = optimistic_find(key) != nullptr;
+        IBRManager::end_op();
+        return found;
+    }
 
+    // Looks up keys[0..count) under one mutex acquisition, or one IBR
+    // operation for lock-free and seqlock finds, leaving each key's value
+    // (if present) in values. Every bucket is prefetched before the first
+    // probe, so the misses overlap.
+    void multi_get(const int* keys, size_t count, std::optional<int>* values) {
+        IBRManager::DeferPressure defer; // Outlives the lock below
+        IBRManager::start_op();
+        if (find_mode == FindMode::Locked) {
+            std::lock_guard<std::mutex> lock(global_lock);
+            Table* t = table.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < count; ++i) __builtin_prefetch(&bucket(t, keys[i]));
+            for (size_t i = 0; i < count; ++i) {
+                Node* node = find_link(t, keys[i])->load(std::memory_order_relaxed);
+                values[i] = node ? std::optional<int>(node->value) : std::nullopt;
+            }
+        } else {
+            Table* t = table.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++i) __builtin_prefetch(&bucket(t, keys[i]));
+            for (size_t i = 0; i < count; ++i) {
+                Node* node = optimistic_find(keys[i]);
+                values[i] = node ? std::optional<int>(node->value) : std::nullopt;
+            }
+        }
         IBRManager::end_op();
-        return false;
     }
 
-    bool find(int key) {
+    // Inserts or overwrites every pair in one write section
+    void multi_put(const std::pair<int, int>* items, size_t count) {
+        IBRManager::DeferPressure defer; // Outlives the lock below
         IBRManager::start_op();
         std::lock_guard<std::mutex> lock(global_lock);
+        WriteSection write(seq);
 
-        bool found = map.find(key) != map.end();
+        Table* t = table.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) __builtin_prefetch(&bucket(t, items[i].first));
+        for (size_t i = 0; i < count; ++i) put_locked(items[i].first, items[i].second);
         IBRManager::end_op();
-        return found;
+    }
+
+    // Removes every key in one write section; returns how many were present
+    size_t multi_remove(const int* keys, size_t count) {
+        IBRManager::DeferPressure defer; // Outlives the lock below
+        IBRManager::start_op();
+        std::lock_guard<std::mutex> lock(global_lock);
+        WriteSection write(seq);
+
+        Table* t = table.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) __builtin_prefetch(&bucket(t, keys[i]));
+        size_t removed = 0;
+        for (size_t i = 0; i < count; ++i) removed += remove_locked(keys[i]);
+        IBRManager::end_op();
+        return removed;
+    }
+
+private:
+    // Under the lock, inside a write section
+    void put_locked(int key, int value) {
+        Table* t = table.load(std::memory_order_relaxed);
+        std::atomic<Node*>* link = find_link(t, key);
+        Node* node = IBRManager::allocate_node<Node>(key, value);
+        if (Node* old = link->load(std::memory_order_relaxed)) {
+            node->next.store(old->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            link->store(node, std::memory_order_release);
+            IBRManager::retire_node(old);
+        } else {
+            node->next.store(bucket(t, key).load(std::memory_order_relaxed), std::memory_order_relaxed);
+            bucket(t, key).store(node, std::memory_order_release);
+            if (++t->count > t->mask + 1) grow();
+        }
+    }
+
+    // Under the lock, inside a write section
+    bool remove_locked(int key) {
+        Table* t = table.load(std::memory_order_relaxed);
+        std::atomic<Node*>* link = find_link(t, key);
+        Node* node = link->load(std::memory_order_relaxed);
+        if (!node) return false;
+        link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+        --t->count;
+        IBRManager::retire_node(node);
+        return true;
+    }
+
+    // Inside an IBR operation; a seqlock find retries until no write overlapped it
+    Node* optimistic_find(int key) {
+        while (true) {
+            uint64_t before = seq.load(std::memory_order_acquire);
+            if (find_mode == FindMode::Seqlock && (before & 1)) {
+                std::this_thread::yield();
+                continue;
+            }
+            Table* t = table.load(std::memory_order_acquire);
+            Node* node = bucket(t, key).load(std::memory_order_acquire);
+            while (node && node->key != key) {
+                node = node->next.load(std::memory_order_acquire);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (find_mode == FindMode::LockFree || seq.load(std::memory_order_relaxed) == before) return node;
+        }
     }
 };
 
-// Benchmarking
-void benchmark(int thread_count, int total_operations) {
-    SGLUnorderedMap sgl_map;
+// The benchmark loop drives every map through these; maps other than
+// SGLUnorderedMap take a thread index like HyalineSGL's, and a combined
+// SGLUnorderedMap posts the call for whichever thread is combining
+void put(SGLUnorderedMap& map, int key, int value, int) { map.insert(key, value); }
+void erase(SGLUnorderedMap& map, int key, int) { map.remove(key); }
+void lookup(SGLUnorderedMap& map, int key, int) { map.find(key); }
+// The combiner runs other threads' operations on its own behalf, so any
+// over-budget work they leave it waits until it has stopped combining
+void put(FlatCombining<SGLUnorderedMap>& fc, int key, int value, int tid) {
+    IBRManager::DeferPressure defer;
+    fc.apply([&](SGLUnorderedMap& map, int) { map.insert(key, value); return true; }, tid);
+}
+void erase(FlatCombining<SGLUnorderedMap>& fc, int key, int tid) {
+    IBRManager::DeferPressure defer;
+    fc.apply([&](SGLUnorderedMap& map, int) { return map.remove(key); }, tid);
+}
+void lookup(FlatCombining<SGLUnorderedMap>& fc, int key, int tid) {
+    IBRManager::DeferPressure defer;
+    fc.apply([&](SGLUnorderedMap& map, int) { return map.find(key); }, tid);
+}
+template <class Map> void put(Map& map, int key, int value, int tid) { map.put(key, value, tid); }
+template <class Map> void erase(Map& map, int key, int tid) { map.remove(key, tid); }
+template <class Map> void lookup(Map& map, int key, int tid) { map.get(key, tid); }
+
+// Benchmarking; reads is the percentage of operations that are lookups,
+// the rest are put/erase pairs
+template <class Map>
+void benchmark(Map& sgl_map, int thread_count, int total_operations, int reads) {
     std::atomic<int> operation_count{0};
     std::vector<std::thread> threads;
     auto start_time = std::chrono::high_resolution_clock::now();
 
     for (int i = 0; i < thread_count; ++i) {
-        threads.emplace_back([&]() {
+        threads.emplace_back([&, i]() {
             std::mt19937 rng(std::random_device{}());
             std::uniform_int_distribution<int> dist(0, 1000);
 
+            std::uniform_int_distribution<int> percent(0, 99);
+
             while (operation_count.load() < total_operations) {
                 int key = dist(rng);
-                sgl_map.insert(key, dist(rng));
-                sgl_map.remove(key);
+                if (reads > 0 && percent(rng) < reads) {
+                    lookup(sgl_map, key, i);
+                    operation_count.fetch_add(1);
+                    continue;
+                }
+                put(sgl_map, key, dist(rng), i);
+                erase(sgl_map, key, i);
                 operation_count.fetch_add(2);
             }
         });
@@ -133,21 +312,133 @@ void benchmark(int thread_count, int total_operations) {
 
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end_time - start_time;
-    double throughput = static_cast<double>(total_operations) / elapsed.count();
+    // Threads finish the round they are in, so more than total_operations may run
+    double throughput = static_cast<double>(operation_count.load()) / elapsed.count();
     std::cout << "Threads: " << thread_count << " | Throughput: " << throughput << " ops/sec" << std::endl;
 }
 
+// Same mix, but in batches of keys: a multi_get for lookups, and for updates
+// a multi_put followed by a multi_remove of the same keys, so the mutex and
+// IBR operation are paid once per batch; throughput counts keys
+void benchmark_batched(SGLUnorderedMap& sgl_map, int thread_count, int total_operations, int reads, int batch) {
+    std::atomic<int> operation_count{0};
+    std::vector<std::thread> threads;
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&]() {
+            std::mt19937 rng(std::random_device{}());
+            std::uniform_int_distribution<int> dist(0, 1000);
+            std::uniform_int_distribution<int> percent(0, 99);
+            std::vector<int> keys(batch);
+            std::vector<std::optional<int>> values(batch);
+            std::vector<std::pair<int, int>> items(batch);
+
+            while (operation_count.load() < total_operations) {
+                for (int& key : keys) key = dist(rng);
+                if (reads > 0 && percent(rng) < reads) {
+                    sgl_map.multi_get(keys.data(), batch, values.data());
+                    operation_count.fetch_add(batch);
+                    continue;
+                }
+                for (int k = 0; k < batch; ++k) items[k] = {keys[k], dist(rng)};
+                sgl_map.multi_put(items.data(), batch);
+                sgl_map.multi_remove(keys.data(), batch);
+                operation_count.fetch_add(2 * batch);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    // Threads finish the round they are in, so more than total_operations may run
+    double throughput = static_cast<double>(operation_count.load()) / elapsed.count();
+    std::cout << "Threads: " << thread_count << " | Batch: " << batch << " | Throughput: " << throughput << " keys/sec"
+              << std::endl;
+}
+
 int main(int argc, char* argv[]) {
     int thread_count;
-    if (argc == 2) {
+    if (argc >= 2) {
         thread_count = std::stoi(argv[1]);
     }
     else {
         thread_count = 4;
     }
-    std::cout << "The thread count is: " << thread_count << std::endl;
+    bool background = false;
+    std::string kind = "sgl";
+    long budget = 0;
+    int shards = 64;
+    int reads = 0;
+    int batch = 0;
+    FindMode find_mode = FindMode::Locked;
+    for (int a = 2; a < argc; ++a) {
+        std::string option = argv[a];
+        if (option == "background") background = true;
+        else if (option == "lockfree" || option == "splitorder" || option == "sharded" || option == "combining") kind = option;
+        else if (option.rfind("shards=", 0) == 0) shards = std::stoi(option.substr(7));
+        else if (option.rfind("reads=", 0) == 0) reads = std::stoi(option.substr(6));
+        else if (option == "get=lockfree") find_mode = FindMode::LockFree;
+        else if (option == "get=seqlock") find_mode = FindMode::Seqlock;
+        else if (option == "readmodes") kind = option;
+        else if (option.rfind("budget=", 0) == 0) budget = std::stol(option.substr(7));
+        else if (option.rfind("batch=", 0) == 0) batch = std::stoi(option.substr(6));
+    }
+    std::cout << "The thread count is: " << thread_count << " | Reads: " << reads << "%" << std::endl;
+    IBRManager::set_unreclaimed_budget(budget);
+    if (background) {
+        std::cout << "Reclamation: background thread" << std::endl;
+        IBRManager::start_background_reclaimer();
+    }
     int total_operations = 10000; // Define total number of operations
 
-    benchmark(thread_count, total_operations);
+    if (kind == "lockfree") {
+        std::cout << "Map: Michael lock-free hash map" << std::endl;
+        IBRReclaimer reclaimer(thread_count); // Background reclaimer, if any, is managed above
+        MichaelHashMap<int, int, IBRReclaimer> map(reclaimer);
+        benchmark(map, thread_count, total_operations, reads);
+    } else if (kind == "splitorder") {
+        std::cout << "Map: split-ordered hash map" << std::endl;
+        IBRReclaimer reclaimer(thread_count);
+        SplitOrderedMap<int, int, IBRReclaimer> map(reclaimer);
+        benchmark(map, thread_count, total_operations, reads);
+    } else if (kind == "sharded") {
+        std::cout << "Map: " << shards << " locked shards" << std::endl;
+        ShardedUnorderedMap<int, int> map(shards);
+        benchmark(map, thread_count, total_operations, reads);
+    } else if (kind == "combining") {
+        std::cout << "Map: single global lock, flat combining" << std::endl;
+        FlatCombining<SGLUnorderedMap> map(thread_count);
+        benchmark(map, thread_count, total_operations, reads);
+        std::cout << "Average batch: " << map.averageBatch() << " ops" << std::endl;
+    } else if (kind == "readmodes") {
+        // Each find mode of the single-global-lock map, from balanced to read-mostly
+        for (int r : {50, 75, 90, 95, 99}) {
+            for (FindMode mode : {FindMode::Locked, FindMode::LockFree, FindMode::Seqlock}) {
+                std::cout << "Reads: " << r << "% | Map: single global lock, " << find_mode_name(mode) << " finds"
+                          << std::endl;
+                SGLUnorderedMap sgl_map(mode);
+                benchmark(sgl_map, thread_count, total_operations, r);
+            }
+        }
+    } else {
+        std::cout << "Map: single global lock, " << find_mode_name(find_mode) << " finds" << std::endl;
+        SGLUnorderedMap sgl_map(find_mode);
+        if (batch > 0) benchmark_batched(sgl_map, thread_count, total_operations, reads, batch);
+        else benchmark(sgl_map, thread_count, total_operations, reads);
+    }
+    if (background) IBRManager::stop_background_reclaimer();
+    if (budget > 0) {
+        std::cout << "Budget: " << budget << " nodes | Pressure scans: " << IBRManager::pressure_scans
+                  << " | Epoch advances: " << IBRManager::pressure_epoch_advances
+                  << " | Stalls: " << IBRManager::pressure_stalls << std::endl;
+    }
+
+    // Final clean-up of any residual retired nodes
+    IBRManager::final_clean_up();
     return 0;
 }
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "asymmetric_fence.h"
+#include "epoch_scan.h"
+#include "spsc_ring.h"
+
+// Header embedded in every object managed by IBRManager
+struct IBRNode {
+    std::atomic<int> birth_epoch{0};
+    std::atomic<int> retire_epoch{-1};
+
+    virtual ~IBRNode() = default;
+};
+
+// Memory management API for IBR
+class IBRManager {
+public:
+    static constexpr int kMaxThreads = 1024; // Upper bound on registered threads
+    static constexpr int kEpochFreq = 64;    // Retires per thread between epoch advances
+    static constexpr int kCleanupFreq = 32;  // Retires per thread between clean_up passes
+    static constexpr int kMaxBackoffRounds = 10; // Backpressure sleeps 1us..512us per round
+    static constexpr int kInactive = INT_MAX; // Reservation of a thread outside an operation
+
+    inline static std::atomic<int> global_epoch{0};
+    inline static std::atomic<long> unreclaimed{0}; // Retired but not yet freed, all threads
+    inline static std::atomic<long> unreclaimed_budget{0}; // 0 = unbounded
+
+    // How often each stage of the over-budget path fired; retire_node notices
+    // the overrun and end_op deals with it
+    inline static std::atomic<long> pressure_scans{0};
+    inline static std::atomic<long> pressure_epoch_advances{0};
+    inline static std::atomic<long> pressure_stalls{0};
+
+    inline thread_local static int local_epoch = -1;
+    inline thread_local static std::list<IBRNode*> retired_nodes;
+
+    static void start_op() {
+        local_epoch = global_epoch.load();
+        if (asymmetric.load(std::memory_order_relaxed)) {
+            // get_min_active_epoch issues the matching membarrier before scanning
+            reservations[thread_index()].store(local_epoch, std::memory_order_relaxed);
+            asymmetric_fence::light();
+        } else {
+            // seq_cst store: the reservation must be visible before we read shared nodes
+            reservations[thread_index()].store(local_epoch);
+        }
+    }
+
+    static void end_op() {
+        local_epoch = -1;  // Reset epoch
+        reservations[thread_index()].store(kInactive, std::memory_order_release);
+        if (pressure_pending && pressure_deferrals == 0) {
+            relieve_pressure();
+        }
+    }
+
+    // Postpones the over-budget work of every end_op in its scope until the
+    // scope closes. Declare it before taking a lock that is held across
+    // end_op, so that work never runs, or sleeps, with the lock held.
+    struct DeferPressure {
+        DeferPressure() { ++pressure_deferrals; }
+
+        ~DeferPressure() {
+            if (--pressure_deferrals == 0 && pressure_pending && local_epoch == -1) {
+                relieve_pressure();
+            }
+        }
+    };
+
+    template <class T, class... Args>
+    static T* allocate_node(Args&&... args) {
+        T* node = new T(std::forward<Args>(args)...);
+        node->birth_epoch = global_epoch.load();
+        return node;
+    }
+
+    static void retire_node(IBRNode* node) {
+        node->retire_epoch = global_epoch.load();
+        unreclaimed.fetch_add(1, std::memory_order_relaxed);
+        if (background.load(std::memory_order_relaxed) && handoff[thread_index()].push(node)) {
+            // The reclaimer thread scans and frees it
+        } else {
+            retired_nodes.push_back(node);
+            if (++retire_count % kEpochFreq == 0) {
+                global_epoch.fetch_add(1);
+            }
+            if (retire_count % kCleanupFreq == 0) {
+                clean_up();
+            }
+        }
+
+        // Relieved once the operation ends, when this thread no longer pins anything
+        long budget = unreclaimed_budget.load(std::memory_order_relaxed);
+        if (budget > 0 && unreclaimed.load(std::memory_order_relaxed) > budget) {
+            pressure_pending = true;
+        }
+    }
+
+    static void clean_up() {
+        if (has_orphans.load(std::memory_order_relaxed)) {
+            adopt_orphans();
+        }
+        // One reservation scan per pass instead of one per retired node
+        int min_epoch = get_min_active_epoch();
+        long freed = 0;
+        for (auto it = retired_nodes.begin(); it != retired_nodes.end();) {
+            IBRNode* node = *it;
+            if (node->retire_epoch.load(std::memory_order_relaxed) < min_epoch) {
+                delete node;  // Free memory
+                it = retired_nodes.erase(it);  // Remove from list
+                ++freed;
+            } else {
+                ++it;
+            }
+        }
+        unreclaimed.fetch_sub(freed, std::memory_order_relaxed);
+    }
+
+    // Frees everything retired by this thread and by threads that have exited.
+    // Only safe once no thread is inside an operation.
+    static void final_clean_up() {
+        adopt_orphans();
+        for (auto node : retired_nodes) {
+            delete node;
+        }
+        unreclaimed.fetch_sub(retired_nodes.size(), std::memory_order_relaxed);
+        retired_nodes.clear();
+    }
+
+    // Drop the store-load fence from start_op and have reclaimers issue a
+    // membarrier instead. Call before any thread starts an operation; returns
+    // whether the mode is in effect (false if the kernel lacks membarrier).
+    static bool set_asymmetric_fences(bool enable) {
+        asymmetric.store(enable && asymmetric_fence::init());
+        return asymmetric.load();
+    }
+
+    // Cap on retired-but-unfreed nodes across all threads; 0 disables the cap
+    static void set_unreclaimed_budget(long nodes) {
+        unreclaimed_budget.store(nodes);
+    }
+
+    // Hand every later retire_node to a dedicated thread that advances the
+    // epoch, scans reservations and frees, so workers do no reclamation work.
+    static void start_background_reclaimer() {
+        background.store(true);
+        running.store(true);
+        reclaimer = std::thread(reclaimer_loop);
+    }
+
+    // Must be called once no thread is inside an operation
+    static void stop_background_reclaimer() {
+        running.store(false, std::memory_order_release);
+        reclaimer.join();
+        background.store(false);
+    }
+
+private:
+    static_assert(sizeof(std::atomic<int>) == sizeof(int), "reservations are scanned as a packed int array");
+
+    // Packed so the scan can compare 8 (AVX2) or 4 (SSE4.1) reservations per instruction
+    alignas(64) inline static std::atomic<int> reservations[kMaxThreads];
+    inline static std::atomic<int> registered_threads{0}; // High-water mark of used indices
+    inline thread_local static long retire_count = 0;
+    inline thread_local static bool pressure_pending = false; // Went over budget during the current operation
+    inline thread_local static int pressure_deferrals = 0;    // Open DeferPressure scopes
+
+    // Indices of exited threads and the nodes they could not free yet
+    inline static std::mutex registry_lock;
+    inline static std::vector<int> free_indices;
+    inline static std::list<IBRNode*> orphans;
+    inline static std::atomic<bool> has_orphans{false};
+
+    // Registers the thread on first use and hands its leftovers over at exit
+    struct ThreadRecord {
+        int index;
+
+        ThreadRecord() {
+            retired_nodes.clear(); // Construct the list first so it outlives this record
+            index = register_thread();
+        }
+
+        ~ThreadRecord() {
+            std::lock_guard<std::mutex> lock(registry_lock);
+            reservations[index].store(kInactive);
+            if (!retired_nodes.empty()) {
+                orphans.splice(orphans.end(), retired_nodes);
+                has_orphans.store(true, std::memory_order_relaxed);
+            }
+            free_indices.push_back(index);
+        }
+    };
+
+    // Worker -> reclaimer thread, one ring per registered thread
+    inline static SpscRing<IBRNode*, 256> handoff[kMaxThreads];
+    inline static std::atomic<bool> background{false};
+    inline static std::atomic<bool> asymmetric{false};
+    inline static std::atomic<bool> running{false};
+    inline static std::thread reclaimer;
+
+    // Over budget: scan now, then push the epoch forward, then slow the caller down.
+    // Runs between operations, so the caller's own reservation is not among
+    // those holding the garbage back. A reader stalled inside start_op pins
+    // everything retired after its epoch, so the last stage is bounded rather
+    // than waiting for it indefinitely.
+    static void relieve_pressure() {
+        pressure_pending = false;
+        long budget = unreclaimed_budget.load(std::memory_order_relaxed);
+        if (budget <= 0 || unreclaimed.load(std::memory_order_relaxed) <= budget) return;
+
+        pressure_scans.fetch_add(1, std::memory_order_relaxed);
+        clean_up();
+        if (unreclaimed.load(std::memory_order_relaxed) <= budget) return;
+
+        pressure_epoch_advances.fetch_add(1, std::memory_order_relaxed);
+        global_epoch.fetch_add(1);
+        clean_up();
+        if (unreclaimed.load(std::memory_order_relaxed) <= budget) return;
+
+        pressure_stalls.fetch_add(1, std::memory_order_relaxed);
+        for (int round = 0; round < kMaxBackoffRounds; ++round) {
+            std::this_thread::sleep_for(std::chrono::microseconds(1 << round));
+            clean_up();
+            if (unreclaimed.load(std::memory_order_relaxed) <= budget) return;
+        }
+    }
+
+    static int thread_index() {
+        thread_local ThreadRecord record;
+        return record.index;
+    }
+
+    static int register_thread() {
+        std::lock_guard<std::mutex> lock(registry_lock);
+        if (!free_indices.empty()) {
+            int index = free_indices.back();
+            free_indices.pop_back();
+            return index;
+        }
+        int index = registered_threads.load(std::memory_order_relaxed);
+        assert(index < kMaxThreads);
+        reservations[index].store(kInactive);
+        registered_threads.store(index + 1, std::memory_order_release);
+        return index;
+    }
+
+    static void adopt_orphans() {
+        std::lock_guard<std::mutex> lock(registry_lock);
+        retired_nodes.splice(retired_nodes.end(), orphans);
+        has_orphans.store(false, std::memory_order_relaxed);
+    }
+
+    // Runs on the reclaimer thread, so retired_nodes is its own list
+    static bool drain_handoffs() {
+        bool drained = false;
+        int count = registered_threads.load(std::memory_order_acquire);
+        IBRNode* node;
+        for (int i = 0; i < count; ++i) {
+            while (handoff[i].pop(node)) {
+                retired_nodes.push_back(node);
+                drained = true;
+            }
+        }
+        return drained;
+    }
+
+    static void reclaimer_loop() {
+        while (running.load(std::memory_order_acquire)) {
+            if (drain_handoffs()) {
+                global_epoch.fetch_add(1);
+                clean_up();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        drain_handoffs();
+        final_clean_up();
+    }
+
+    static int get_min_active_epoch() {
+        // Pairs with the seq_cst store in start_op: either the reader sees the
+        // unlink that preceded this retire, or we see its reservation.
+        if (asymmetric.load(std::memory_order_relaxed)) {
+            asymmetric_fence::heavy();
+        } else {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        int count = registered_threads.load(std::memory_order_acquire);
+        // Entries are naturally aligned ints, so each lane of a vector load is a
+        // single-copy-atomic read on x86.
+        int min_epoch = epoch_scan::min_epoch(reinterpret_cast<const int*>(reservations), count);
+        // With nobody active, anything retired before the current epoch is free
+        return min_epoch == kInactive ? global_epoch.load() : min_epoch;
+    }
+};
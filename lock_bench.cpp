@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spin_locks.h"
+
+// Lock handoff latency for each SGLUnorderedMap lock policy. Threads take
+// the lock in a tight loop around a tiny critical section. Whenever the lock
+// changes owner, the new owner records how long it has been since the last
+// owner released it; that gap is the handoff latency, and it is what limits
+// throughput once every thread is waiting on the same lock.
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    double throughput;   // Acquisitions per second
+    double handoffNs;    // Mean release-to-acquire gap when the owner changes
+    double handoffShare; // Fraction of acquisitions that changed owner
+    double fairness;     // Fewest acquisitions by one thread over the most
+};
+
+template <class Lock>
+Result run(int threads, double seconds, int outsideWork) {
+    Lock lock(threads);
+    std::atomic<bool> stop{false};
+    std::vector<long> acquired(threads * 8); // Padded: thread i writes slot i * 8
+
+    // Shared state, only touched while holding the lock
+    int owner = -1;
+    Clock::time_point releasedAt;
+    long handoffs = 0;
+    double handoffTotal = 0;
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            long mine = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                lock.lock(i);
+                Clock::time_point now = Clock::now();
+                if (owner != i && owner != -1) {
+                    handoffTotal += std::chrono::duration<double, std::nano>(now - releasedAt).count();
+                    ++handoffs;
+                }
+                owner = i;
+                releasedAt = Clock::now();
+                lock.unlock(i);
+                ++mine;
+                for (int w = 0; w < outsideWork; ++w) cpuRelax();
+            }
+            acquired[i * 8] = mine;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    long total = 0, fewest = -1, most = 0;
+    for (int i = 0; i < threads; ++i) {
+        long n = acquired[i * 8];
+        total += n;
+        most = std::max(most, n);
+        fewest = fewest < 0 ? n : std::min(fewest, n);
+    }
+    return {total / seconds, handoffs ? handoffTotal / handoffs : 0, total ? static_cast<double>(handoffs) / total : 0,
+            most ? static_cast<double>(fewest) / most : 0};
+}
+
+template <class Lock>
+void report(int threads, double seconds, int outsideWork) {
+    Result r = run<Lock>(threads, seconds, outsideWork);
+    std::cout << Lock::name() << " | Throughput: " << r.throughput << " acquisitions/sec | Handoff: " << r.handoffNs
+              << " ns | Owner changes: " << 100 * r.handoffShare << "% | Fairness: " << r.fairness << std::endl;
+}
+
+// ./lock_bench [threads] [outside work] [seconds per lock]
+int main(int argc, char* argv[]) {
+    int threads = argc >= 2 ? std::stoi(argv[1]) : 4;
+    int outsideWork = argc >= 3 ? std::stoi(argv[2]) : 0;
+    double seconds = argc >= 4 ? std::stod(argv[3]) : 1.0;
+    std::cout << "The thread count is: " << threads << " | Work outside the lock: " << outsideWork << " pauses"
+              << std::endl;
+
+    report<CASLock>(threads, seconds, outsideWork);
+    report<TASLock>(threads, seconds, outsideWork);
+    report<TicketLock>(threads, seconds, outsideWork);
+    report<MCSLock>(threads, seconds, outsideWork);
+    report<CLHLock>(threads, seconds, outsideWork);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+
+#include "harris_list.h"
+
+// Michael's lock-free hash map (SPAA 2002): a fixed power-of-two array of
+// buckets, each a Harris-Michael list. Same insert/put/replace/remove/get
+// interface as SGLUnorderedMap, so the map benchmarks can swap it in; removed
+// nodes are retired through the reclaimer.
+template <class K, class V, class Reclaimer>
+class MichaelHashMap {
+    using List = HarrisMichaelList<Reclaimer, K, V>;
+    using Link = typename List::Link;
+
+public:
+    explicit MichaelHashMap(Reclaimer& reclaimer, size_t buckets = 1 << 14)
+        : reclaimer(reclaimer), mask(roundUp(buckets) - 1), table(new Link[mask + 1]()) {}
+
+    ~MichaelHashMap() {
+        for (size_t i = 0; i <= mask; ++i) List::freeList(table[i]);
+        delete[] table;
+    }
+
+    bool insert(K key, V val, int tid) {
+        reclaimer.enter(tid);
+        bool inserted = List::insertAt(reclaimer, bucket(key), key, val, tid);
+        reclaimer.leave(tid);
+        return inserted;
+    }
+
+    std::optional<V> put(K key, V val, int tid) {
+        reclaimer.enter(tid);
+        std::optional<V> res = List::putAt(reclaimer, bucket(key), key, val, tid);
+        reclaimer.leave(tid);
+        return res;
+    }
+
+    std::optional<V> replace(K key, V val, int tid) {
+        reclaimer.enter(tid);
+        std::optional<V> res = List::replaceAt(reclaimer, bucket(key), key, val, tid);
+        reclaimer.leave(tid);
+        return res;
+    }
+
+    std::optional<V> remove(K key, int tid) {
+        reclaimer.enter(tid);
+        std::optional<V> res = List::removeAt(reclaimer, bucket(key), key, tid);
+        reclaimer.leave(tid);
+        return res;
+    }
+
+    std::optional<V> get(K key, int tid) {
+        reclaimer.enter(tid);
+        std::optional<V> res = List::getAt(bucket(key), key);
+        reclaimer.leave(tid);
+        return res;
+    }
+
+private:
+    Reclaimer& reclaimer;
+    const size_t mask;
+    Link* const table;
+
+    static size_t roundUp(size_t n) {
+        size_t size = 1;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+    Link& bucket(const K& key) { return table[std::hash<K>()(key) & mask]; }
+};
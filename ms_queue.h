@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+
+// Michael-Scott lock-free queue (PODC 1996). A dummy node sits at the head;
+// a pop swings head to the next node, takes its value and retires the old
+// dummy. Nodes are only retired once unreachable, so the reclaimer also rules
+// out ABA on head and tail.
+template <class Reclaimer>
+class MSQueue {
+public:
+    explicit MSQueue(Reclaimer& reclaimer) : reclaimer(reclaimer) {
+        Node* dummy = new Node(0);
+        head.store(dummy);
+        tail.store(dummy);
+    }
+
+    ~MSQueue() {
+        Node* curr = head.load();
+        while (curr) {
+            Node* next = curr->next.load();
+            delete curr;
+            curr = next;
+        }
+    }
+
+    void push(int value, int tid) {
+        Node* node = new Node(value);
+        reclaimer.enter(tid);
+        while (true) {
+            Node* last = tail.load(std::memory_order_acquire);
+            Node* next = last->next.load(std::memory_order_acquire);
+            if (last != tail.load(std::memory_order_acquire)) continue;
+            if (next) {
+                tail.compare_exchange_weak(last, next); // Help a lagging tail along
+                continue;
+            }
+            if (last->next.compare_exchange_weak(next, node)) {
+                tail.compare_exchange_strong(last, node);
+                break;
+            }
+        }
+        reclaimer.leave(tid);
+    }
+
+    std::optional<int> pop(int tid) {
+        reclaimer.enter(tid);
+        std::optional<int> res;
+        while (true) {
+            Node* first = head.load(std::memory_order_acquire);
+            Node* last = tail.load(std::memory_order_acquire);
+            Node* next = first->next.load(std::memory_order_acquire);
+            if (first != head.load(std::memory_order_acquire)) continue;
+            if (!next) break; // Empty
+            if (first == last) {
+                tail.compare_exchange_weak(last, next);
+                continue;
+            }
+            int value = next->value;
+            if (head.compare_exchange_weak(first, next)) {
+                reclaimer.retire(first, tid);
+                res = value;
+                break;
+            }
+        }
+        reclaimer.leave(tid);
+        return res;
+    }
+
+private:
+    struct Node : Reclaimer::Node {
+        const int value;
+        std::atomic<Node*> next{nullptr};
+
+        explicit Node(int v) : value(v) {}
+    };
+
+    Reclaimer& reclaimer;
+    alignas(64) std::atomic<Node*> head; // Consumers and producers on separate lines
+    alignas(64) std::atomic<Node*> tail;
+};
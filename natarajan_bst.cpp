@@ -0,0 +1,10 @@
+#include "natarajan_bst.h"
+#include "set_bench.h"
+
+// Natarajan-Mittal external BST under each reclamation scheme
+int main(int argc, char* argv[]) {
+    SetWorkload workload = parseSetWorkload(argc, argv);
+    runSetWorkload<NatarajanBST, HyalineReclaimer>(workload);
+    runSetWorkload<NatarajanBST, IBRReclaimer>(workload);
+    return 0;
+}
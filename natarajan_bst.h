@@ -0,0 +1,214 @@
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+
+// Natarajan-Mittal lock-free external BST (PPoPP 2014). Keys live in leaves;
+// internal nodes only route. A remove first flags the edge to its leaf
+// (injection), then tags the sibling edge and swings the edge above the
+// deleted leaf's parent to the sibling with one CAS (cleanup). Flagged and
+// tagged edges are never changed again, which is what lets helpers finish a
+// remove they run into. Keys must be below INT_MAX - 2 (the sentinels).
+template <class Reclaimer>
+class NatarajanBST {
+public:
+    explicit NatarajanBST(Reclaimer& reclaimer) : reclaimer(reclaimer) {
+        Node* leaf0 = new Node(kInf0);
+        Node* leaf1 = new Node(kInf1);
+        Node* leaf2 = new Node(kInf2);
+        S = new Node(kInf1, leaf0, leaf1);
+        R = new Node(kInf2, S, leaf2);
+    }
+
+    ~NatarajanBST() {
+        deleteTree(R);
+    }
+
+    bool insert(int key, int tid) {
+        reclaimer.enter(tid);
+        SeekRecord s;
+        Node* newLeaf = new Node(key);
+        bool inserted;
+        while (true) {
+            seek(key, s);
+            Node* leaf = s.leaf;
+            if (leaf->key == key) {
+                delete newLeaf; // Never published
+                inserted = false;
+                break;
+            }
+            Node* parent = s.parent;
+            std::atomic<uintptr_t>& childAddr = key < parent->key ? parent->left : parent->right;
+            Node* newInternal = key < leaf->key ? new Node(leaf->key, newLeaf, leaf)
+                                                : new Node(key, leaf, newLeaf);
+            uintptr_t expected = edge(leaf);
+            if (childAddr.compare_exchange_strong(expected, edge(newInternal))) {
+                inserted = true;
+                break;
+            }
+            delete newInternal; // Never published; its children are not owned by it
+            // Help a pending remove that holds this edge
+            if (address(expected) == leaf && (expected & (kFlag | kTag))) {
+                cleanup(key, s, tid);
+            }
+        }
+        reclaimer.leave(tid);
+        return inserted;
+    }
+
+    bool remove(int key, int tid) {
+        reclaimer.enter(tid);
+        SeekRecord s;
+        bool injecting = true;
+        Node* leaf = nullptr;
+        bool removed;
+        while (true) {
+            seek(key, s);
+            Node* parent = s.parent;
+            std::atomic<uintptr_t>& childAddr = key < parent->key ? parent->left : parent->right;
+            if (injecting) {
+                leaf = s.leaf;
+                if (leaf->key != key) {
+                    removed = false;
+                    break;
+                }
+                uintptr_t expected = edge(leaf);
+                if (childAddr.compare_exchange_strong(expected, edge(leaf) | kFlag)) {
+                    injecting = false;
+                    if (cleanup(key, s, tid)) {
+                        removed = true;
+                        break;
+                    }
+                } else if (address(expected) == leaf && (expected & (kFlag | kTag))) {
+                    cleanup(key, s, tid);
+                }
+            } else {
+                // Our leaf is flagged; done once someone has swung it out
+                if (s.leaf != leaf || cleanup(key, s, tid)) {
+                    removed = true;
+                    break;
+                }
+            }
+        }
+        reclaimer.leave(tid);
+        return removed;
+    }
+
+    bool contains(int key, int tid) {
+        reclaimer.enter(tid);
+        SeekRecord s;
+        seek(key, s);
+        bool found = s.leaf->key == key;
+        reclaimer.leave(tid);
+        return found;
+    }
+
+private:
+    static constexpr int kInf0 = INT_MAX - 2;
+    static constexpr int kInf1 = INT_MAX - 1;
+    static constexpr int kInf2 = INT_MAX;
+    static constexpr uintptr_t kFlag = 1; // Edge leads to a leaf being removed
+    static constexpr uintptr_t kTag = 2;  // Edge is frozen: its sibling is being removed
+
+    struct Node : Reclaimer::Node {
+        const int key;
+        std::atomic<uintptr_t> left;  // Child edge: pointer | kFlag | kTag
+        std::atomic<uintptr_t> right;
+
+        explicit Node(int k) : key(k), left(0), right(0) {}
+        Node(int k, Node* l, Node* r) : key(k), left(edge(l)), right(edge(r)) {}
+    };
+
+    struct SeekRecord {
+        Node* ancestor;
+        Node* successor;
+        Node* parent;
+        Node* leaf;
+    };
+
+    Reclaimer& reclaimer;
+    Node* R;
+    Node* S;
+
+    static uintptr_t edge(Node* node) { return reinterpret_cast<uintptr_t>(node); }
+    static Node* address(uintptr_t field) { return reinterpret_cast<Node*>(field & ~(kFlag | kTag)); }
+
+    // Find the leaf for key, the deepest ancestor whose edge on the access
+    // path is untagged, and the node just below that ancestor
+    void seek(int key, SeekRecord& s) {
+        s.ancestor = R;
+        s.successor = S;
+        s.parent = S;
+        uintptr_t parentField = S->left.load(std::memory_order_acquire);
+        s.leaf = address(parentField);
+        uintptr_t currentField = s.leaf->left.load(std::memory_order_acquire);
+        Node* current = address(currentField);
+        while (current) {
+            if (!(parentField & kTag)) {
+                s.ancestor = s.parent;
+                s.successor = s.leaf;
+            }
+            s.parent = s.leaf;
+            s.leaf = current;
+            parentField = currentField;
+            currentField = key < current->key ? current->left.load(std::memory_order_acquire)
+                                              : current->right.load(std::memory_order_acquire);
+            current = address(currentField);
+        }
+    }
+
+    // Splice out the flagged leaf below s.parent together with every node on
+    // the tagged chain from s.successor down to it. The winning thread retires
+    // the whole chain.
+    bool cleanup(int key, const SeekRecord& s, int tid) {
+        Node* ancestor = s.ancestor;
+        Node* successor = s.successor;
+        Node* parent = s.parent;
+        std::atomic<uintptr_t>& successorAddr = key < ancestor->key ? ancestor->left : ancestor->right;
+        std::atomic<uintptr_t>* childAddr;
+        std::atomic<uintptr_t>* siblingAddr;
+        if (key < parent->key) {
+            childAddr = &parent->left;
+            siblingAddr = &parent->right;
+        } else {
+            childAddr = &parent->right;
+            siblingAddr = &parent->left;
+        }
+        if (!(childAddr->load(std::memory_order_acquire) & kFlag)) {
+            // The leaf being removed is the sibling of our access path
+            siblingAddr = childAddr;
+        }
+        siblingAddr->fetch_or(kTag);
+        uintptr_t siblingField = siblingAddr->load(std::memory_order_acquire);
+        uintptr_t expected = edge(successor);
+        if (!successorAddr.compare_exchange_strong(expected, siblingField & ~kTag)) {
+            return false;
+        }
+        retireChain(key, successor, parent, siblingAddr, tid);
+        return true;
+    }
+
+    // Every edge on the chain is frozen now, so it can be walked safely
+    void retireChain(int key, Node* node, Node* parent, std::atomic<uintptr_t>* siblingAddr, int tid) {
+        while (node != parent) {
+            uintptr_t next = key < node->key ? node->left.load(std::memory_order_acquire)
+                                             : node->right.load(std::memory_order_acquire);
+            uintptr_t removedLeaf = key < node->key ? node->right.load(std::memory_order_acquire)
+                                                    : node->left.load(std::memory_order_acquire);
+            reclaimer.retire(address(removedLeaf), tid);
+            reclaimer.retire(node, tid);
+            node = address(next);
+        }
+        std::atomic<uintptr_t>& removedEdge = siblingAddr == &parent->left ? parent->right : parent->left;
+        reclaimer.retire(address(removedEdge.load(std::memory_order_acquire)), tid);
+        reclaimer.retire(parent, tid);
+    }
+
+    void deleteTree(Node* node) {
+        if (!node) return;
+        deleteTree(address(node->left.load()));
+        deleteTree(address(node->right.load()));
+        delete node;
+    }
+};
@@ -0,0 +1,119 @@
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ms_queue.h"
+#include "reclaimer.h"
+#include "treiber_stack.h"
+
+// Queue and stack throughput under each reclamation scheme. Every successful
+// pop retires exactly one node, so comparing against a baseline that never
+// frees during the run gives the cost each scheme adds per retire.
+//   pairs     every thread pushes then pops, one retire per pair
+//   prodcons  half the threads only push, the other half only pop
+
+// Keeps every retired node until the end of the run
+class LeakReclaimer {
+public:
+    struct Node {
+        virtual ~Node() = default;
+    };
+
+    explicit LeakReclaimer(int threads, bool = false) : retired(threads) {}
+
+    ~LeakReclaimer() {
+        for (auto& list : retired) {
+            for (Node* node : list.nodes) delete node;
+        }
+    }
+
+    void enter(int) {}
+    void leave(int) {}
+    void retire(Node* node, int tid) { retired[tid].nodes.push_back(node); }
+
+    static const char* name() { return "None"; }
+
+private:
+    struct alignas(64) List {
+        std::vector<Node*> nodes;
+    };
+    std::vector<List> retired;
+};
+
+const int ops_per_thread = 200000;
+
+struct Result {
+    double seconds; // Wall clock
+    double cpu;     // Process CPU time, summed over threads
+    long retires;   // Successful pops
+};
+
+template <template <class> class Container, class Reclaimer>
+Result run(int threads, bool prodcons) {
+    Reclaimer reclaimer(threads);
+    Container<Reclaimer> container(reclaimer);
+    std::atomic<long> popped{0};
+    int producers = prodcons ? threads / 2 : 0;
+    long expected = static_cast<long>(producers) * ops_per_thread;
+
+    std::vector<std::thread> workers;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::clock_t start_cpu = std::clock();
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            if (!prodcons) {
+                long mine = 0;
+                for (int j = 0; j < ops_per_thread; ++j) {
+                    container.push(j, i);
+                    if (container.pop(i)) ++mine;
+                }
+                popped.fetch_add(mine, std::memory_order_relaxed);
+            } else if (i < producers) {
+                for (int j = 0; j < ops_per_thread; ++j) container.push(j, i);
+            } else {
+                // Consumers share the producers' total between them
+                while (popped.load(std::memory_order_relaxed) < expected) {
+                    if (container.pop(i)) popped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    std::clock_t end_cpu = std::clock();
+    std::chrono::duration<double> elapsed = end_time - start_time;
+    return {elapsed.count(), static_cast<double>(end_cpu - start_cpu) / CLOCKS_PER_SEC, popped.load()};
+}
+
+template <template <class> class Container>
+void compare(const char* structure, int threads, bool prodcons) {
+    Result baseline = run<Container, LeakReclaimer>(threads, prodcons);
+    std::cout << structure << " | None    | Throughput: " << 2.0 * baseline.retires / baseline.seconds
+              << " ops/sec" << std::endl;
+    auto report = [&](const char* scheme, const Result& r) {
+        // CPU time over the baseline, spread over the retires
+        double overhead = (r.cpu / r.retires - baseline.cpu / baseline.retires) * 1e9;
+        std::cout << structure << " | " << scheme << " | Throughput: " << 2.0 * r.retires / r.seconds
+                  << " ops/sec | Per retire: " << overhead << " ns" << std::endl;
+    };
+    report("Hyaline", run<Container, HyalineReclaimer>(threads, prodcons));
+    report("IBR    ", run<Container, IBRReclaimer>(threads, prodcons));
+}
+
+// ./queue_bench [threads] [pairs | prodcons]
+int main(int argc, char* argv[]) {
+    int threads = argc >= 2 ? std::stoi(argv[1]) : 4;
+    bool prodcons = argc >= 3 && std::string(argv[2]) == "prodcons";
+    if (prodcons && threads < 2) threads = 2;
+    std::cout << "The thread count is: " << threads << " | Mode: " << (prodcons ? "prodcons" : "pairs") << std::endl;
+
+    compare<MSQueue>("MS queue     ", threads, prodcons);
+    compare<TreiberStack>("Treiber stack", threads, prodcons);
+    return 0;
+}
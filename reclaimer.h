@@ -0,0 +1,64 @@
+#pragma once
+
+#include "hyaline.h"
+#include "ibr_manager.h"
+
+// Uniform front end over Hyaline and IBRManager, so a concurrent data
+// structure can be written once as a template on the reclaimer and
+// benchmarked under either scheme.
+//
+//   Reclaimer::Node           base class for every node the structure retires
+//   enter(tid) / leave(tid)   bracket each operation; nodes reached in between
+//                             stay allocated until leave
+//   retire(node, tid)         hand over a node that is no longer reachable
+//   unreclaimed()             nodes retired but not yet freed
+//
+// tid is a dense thread index in [0, threads).
+
+class HyalineReclaimer {
+public:
+    using Node = HyalineNode;
+
+    explicit HyalineReclaimer(int threads, bool background = false) : hyaline(threads, background) {}
+
+    void enter(int tid) { hyaline.enter(tid); }
+    void leave(int tid) { hyaline.leave(tid); }
+
+    void retire(Node* node, int tid) {
+        node->batchNext = nullptr;
+        hyaline.retire(node, tid);
+    }
+
+    long unreclaimed() const { return hyaline.unreclaimedNodes(); }
+
+    static const char* name() { return "Hyaline"; }
+
+    Hyaline hyaline;
+};
+
+class IBRReclaimer {
+public:
+    using Node = IBRNode;
+
+    explicit IBRReclaimer(int threads, bool background = false) : background(background) {
+        (void)threads; // IBRManager registers threads on first use
+        if (background) IBRManager::start_background_reclaimer();
+    }
+
+    // The owner destroys the reclaimer once every worker has finished
+    ~IBRReclaimer() {
+        if (background) IBRManager::stop_background_reclaimer();
+        IBRManager::final_clean_up();
+    }
+
+    void enter(int) { IBRManager::start_op(); }
+    void leave(int) { IBRManager::end_op(); }
+    void retire(Node* node, int) { IBRManager::retire_node(node); }
+
+    long unreclaimed() const { return IBRManager::unreclaimed.load(std::memory_order_relaxed); }
+
+    static const char* name() { return "IBR"; }
+
+private:
+    const bool background;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "reclaimer.h"
+
+// Shared driver for the concurrent set benchmarks. A set is a template on the
+// reclaimer, constructed from a reference to it, with
+//   bool insert(int key, int tid), bool remove(int key, int tid), bool contains(int key, int tid)
+// Each thread runs a random mix over [0, keyRange); updates are split evenly
+// between insert and remove, so the set stays around half full. Sets that
+// also have
+//   void range(int lo, int hi, Callback visit, int tid)
+// can be given a share of scans over [key, key + scanLength]. The peak number
+// of retired but unfreed nodes seen during scans is reported, so the same set
+// shows how long scans hold back reclamation under each scheme.
+
+struct SetWorkload {
+    int threads = 4;
+    int updatePercent = 50;
+    int keyRange = 10000;
+    int opsPerThread = 100000;
+    int scanPercent = 0;
+    int scanLength = 100;
+};
+
+// ./<benchmark> [threads] [update%] [key range] [scan%] [scan length]
+inline SetWorkload parseSetWorkload(int argc, char* argv[], SetWorkload w = SetWorkload()) {
+    if (argc >= 2) w.threads = std::stoi(argv[1]);
+    if (argc >= 3) w.updatePercent = std::stoi(argv[2]);
+    if (argc >= 4) w.keyRange = std::stoi(argv[3]);
+    if (argc >= 5) w.scanPercent = std::stoi(argv[4]);
+    if (argc >= 6) w.scanLength = std::stoi(argv[5]);
+    std::cout << "The thread count is: " << w.threads << " | Updates: " << w.updatePercent
+              << "% | Keys: " << w.keyRange;
+    if (w.scanPercent > 0) std::cout << " | Scans: " << w.scanPercent << "% of " << w.scanLength << " keys";
+    std::cout << std::endl;
+    return w;
+}
+
+template <class Set, class = void>
+struct HasRange : std::false_type {};
+
+template <class Set>
+struct HasRange<Set, std::void_t<decltype(std::declval<Set&>().range(0, 0, std::declval<void (*)(int)>(), 0))>> : std::true_type {};
+
+template <template <class> class Set, class Reclaimer>
+void runSetWorkload(const SetWorkload& w) {
+    Reclaimer reclaimer(w.threads);
+    double throughput;
+    std::atomic<long> peakUnreclaimed{0};
+    {
+        Set<Reclaimer> set(reclaimer);
+        std::mt19937 prefill(0);
+        for (int i = 0; i < w.keyRange / 2; ++i) {
+            set.insert(prefill() % w.keyRange, 0);
+        }
+
+        std::vector<std::thread> workers;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (int t = 0; t < w.threads; ++t) {
+            workers.emplace_back([&set, &w, &reclaimer, &peakUnreclaimed, t]() {
+                std::mt19937 gen(t + 1);
+                long visited = 0, peak = 0;
+                for (int j = 0; j < w.opsPerThread; ++j) {
+                    int key = gen() % w.keyRange;
+                    int dice = gen() % 100;
+                    if (dice < w.updatePercent / 2) {
+                        set.insert(key, t);
+                    } else if (dice < w.updatePercent) {
+                        set.remove(key, t);
+                    } else if (dice < w.updatePercent + w.scanPercent) {
+                        if constexpr (HasRange<Set<Reclaimer>>::value) {
+                            // Sampled inside the scan, while it holds back reclamation
+                            set.range(key, key + w.scanLength, [&](int) {
+                                if (++visited % 16 == 0) peak = std::max(peak, reclaimer.unreclaimed());
+                            }, t);
+                        } else {
+                            set.contains(key, t);
+                        }
+                    } else {
+                        set.contains(key, t);
+                    }
+                }
+                long seen = peakUnreclaimed.load();
+                while (peak > seen && !peakUnreclaimed.compare_exchange_weak(seen, peak)) {
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        auto end_time = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> elapsed = end_time - start_time;
+        throughput = static_cast<double>(w.threads) * w.opsPerThread / elapsed.count();
+    }
+    std::cout << Reclaimer::name() << " | Threads: " << w.threads << " | Throughput: " << throughput
+              << " ops/sec" << std::endl;
+    if (w.scanPercent > 0 && HasRange<Set<Reclaimer>>::value) {
+        std::cout << Reclaimer::name() << " | Scan length: " << w.scanLength << " keys | Peak unreclaimed: "
+                  << peakUnreclaimed << " nodes" << std::endl;
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "spin_locks.h"
+
+// The single-global-lock map split into independently locked shards: a key
+// hashes to one shard and only that shard's lock is taken, so threads on
+// different shards never wait for each other. The shard count is fixed at
+// construction. Each shard is aligned to its own cache line, so taking one
+// lock does not invalidate a neighbour's lock or map header.
+//
+// Entries are stored by value and erased in place under the shard's lock, so
+// nothing is ever retired and no reclaimer is involved.
+template <class K, class V>
+class ShardedUnorderedMap {
+public:
+    explicit ShardedUnorderedMap(size_t shardCount = 64) : shards(shardCount) {}
+
+    bool insert(K key, V val, int) {
+        Shard& s = shardFor(key);
+        s.lock();
+        bool inserted = s.map.emplace(key, val).second;
+        s.unlock();
+        return inserted;
+    }
+
+    std::optional<V> put(K key, V val, int) {
+        std::optional<V> res = {};
+        Shard& s = shardFor(key);
+        s.lock();
+        auto v = s.map.try_emplace(key, val);
+        if (!v.second) {
+            res = v.first->second;
+            v.first->second = val;
+        }
+        s.unlock();
+        return res;
+    }
+
+    std::optional<V> replace(K key, V val, int) {
+        std::optional<V> res = {};
+        Shard& s = shardFor(key);
+        s.lock();
+        auto v = s.map.find(key);
+        if (v != s.map.end()) {
+            res = v->second;
+            v->second = val;
+        }
+        s.unlock();
+        return res;
+    }
+
+    std::optional<V> remove(K key, int) {
+        std::optional<V> res = {};
+        Shard& s = shardFor(key);
+        s.lock();
+        auto v = s.map.find(key);
+        if (v != s.map.end()) {
+            res = v->second;
+            s.map.erase(v);
+        }
+        s.unlock();
+        return res;
+    }
+
+    std::optional<V> get(K key, int) {
+        std::optional<V> res = {};
+        Shard& s = shardFor(key);
+        s.lock();
+        auto v = s.map.find(key);
+        if (v != s.map.end()) {
+            res = v->second;
+        }
+        s.unlock();
+        return res;
+    }
+
+    size_t shardCount() const { return shards.size(); }
+
+private:
+    // Test-and-test-and-set with exponential backoff, as TASLock, but one byte
+    // rather than a padded line, so lock and map header share a line
+    struct alignas(64) Shard {
+        static constexpr int kMinDelay = 4;
+        static constexpr int kMaxDelay = 4096;
+
+        std::atomic<bool> locked{false};
+        std::unordered_map<K, V> map;
+
+        void lock() {
+            int delay = kMinDelay;
+            while (true) {
+                int spins = 0;
+                while (locked.load(std::memory_order_relaxed)) spinWait(spins);
+                if (!locked.exchange(true, std::memory_order_acquire)) return;
+                for (int i = 0; i < delay; ++i) cpuRelax();
+                delay = std::min(delay * 2, kMaxDelay);
+            }
+        }
+
+        void unlock() { locked.store(false, std::memory_order_release); }
+    };
+
+    std::vector<Shard> shards;
+
+    // Fibonacci mixing, so keys with equal low bits still spread across
+    // shards, then multiply-shift onto [0, shard count)
+    Shard& shardFor(const K& key) {
+        uint64_t h = static_cast<uint64_t>(std::hash<K>()(key)) * 0x9E3779B97F4A7C15ull;
+        return shards[((h >> 32) * shards.size()) >> 32];
+    }
+};
@@ -0,0 +1,11 @@
+#include "set_bench.h"
+#include "skip_list.h"
+
+// Lock-free skip list under each reclamation scheme; with a scan share, long
+// range scans hold one critical section open while updates retire around them
+int main(int argc, char* argv[]) {
+    SetWorkload workload = parseSetWorkload(argc, argv);
+    runSetWorkload<LockFreeSkipList, HyalineReclaimer>(workload);
+    runSetWorkload<LockFreeSkipList, IBRReclaimer>(workload);
+    return 0;
+}
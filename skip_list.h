@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+
+// Lock-free skip list (Fraser 2004; Herlihy, Lev and Shavit 2006). Each level
+// is a Harris-style list with a mark bit in the next pointers. A remove marks
+// its node from the top level down; marking level 0 is the linearization
+// point, and any traversal that meets a marked node unlinks it at that level.
+//
+// A node can still be getting linked into upper levels by its inserter while
+// it is removed, so neither side may retire it alone: both drop a reference
+// after making sure the node is unlinked everywhere, and the last one retires
+// it.
+template <class Reclaimer>
+class LockFreeSkipList {
+public:
+    explicit LockFreeSkipList(Reclaimer& reclaimer) : reclaimer(reclaimer), head(new Node(0, kMaxLevel)) {}
+
+    ~LockFreeSkipList() {
+        Node* curr = head;
+        while (curr) {
+            Node* next = address(curr->next[0].load());
+            delete curr;
+            curr = next;
+        }
+    }
+
+    bool insert(int key, int tid) {
+        reclaimer.enter(tid);
+        Node* preds[kMaxLevel];
+        Node* succs[kMaxLevel];
+        Node* node = nullptr;
+        while (true) {
+            if (find(key, preds, succs)) {
+                delete node; // Never published
+                reclaimer.leave(tid);
+                return false;
+            }
+            if (!node) node = new Node(key, randomLevel());
+            for (int i = 0; i < node->height; ++i) {
+                node->next[i].store(link(succs[i]), std::memory_order_relaxed);
+            }
+            uintptr_t expected = link(succs[0]);
+            if (preds[0]->next[0].compare_exchange_strong(expected, link(node))) break;
+        }
+        // Present from here on; the upper levels are only shortcuts
+        for (int i = 1; i < node->height; ++i) {
+            while (true) {
+                uintptr_t next = node->next[i].load(std::memory_order_acquire);
+                if (next & kMark) goto linked; // Already being removed
+                if (address(next) != succs[i] && !node->next[i].compare_exchange_strong(next, link(succs[i]))) {
+                    goto linked;
+                }
+                uintptr_t expected = link(succs[i]);
+                if (preds[i]->next[i].compare_exchange_strong(expected, link(node))) break;
+                find(key, preds, succs);
+                if (succs[0] != node) goto linked; // Removed and unlinked meanwhile
+            }
+        }
+    linked:
+        if (node->next[0].load(std::memory_order_acquire) & kMark) {
+            find(key, preds, succs); // Undo any level we linked after the remover's sweep
+        }
+        release(node, tid);
+        reclaimer.leave(tid);
+        return true;
+    }
+
+    bool remove(int key, int tid) {
+        reclaimer.enter(tid);
+        Node* preds[kMaxLevel];
+        Node* succs[kMaxLevel];
+        if (!find(key, preds, succs)) {
+            reclaimer.leave(tid);
+            return false;
+        }
+        Node* node = succs[0];
+        for (int i = node->height - 1; i > 0; --i) {
+            node->next[i].fetch_or(kMark);
+        }
+        uintptr_t next = node->next[0].load(std::memory_order_acquire);
+        while (true) {
+            if (next & kMark) {
+                reclaimer.leave(tid); // Another remove got there first
+                return false;
+            }
+            if (node->next[0].compare_exchange_weak(next, next | kMark)) break;
+        }
+        find(key, preds, succs); // Unlink it at every level
+        release(node, tid);
+        reclaimer.leave(tid);
+        return true;
+    }
+
+    // Wait-free: skips marked nodes instead of unlinking them
+    bool contains(int key, int tid) {
+        reclaimer.enter(tid);
+        Node* curr = lowerBound(key);
+        bool found = curr && curr->key == key && !(curr->next[0].load(std::memory_order_acquire) & kMark);
+        reclaimer.leave(tid);
+        return found;
+    }
+
+    // Calls visit(key) in order for each key in [lo, hi] present when the
+    // scan passes it. Not a snapshot: concurrent updates may or may not show.
+    template <class Callback>
+    void range(int lo, int hi, Callback visit, int tid) {
+        reclaimer.enter(tid);
+        Node* curr = lowerBound(lo);
+        while (curr && curr->key <= hi) {
+            uintptr_t next = curr->next[0].load(std::memory_order_acquire);
+            if (!(next & kMark)) visit(curr->key);
+            curr = address(next);
+        }
+        reclaimer.leave(tid);
+    }
+
+private:
+    static constexpr int kMaxLevel = 20;
+    static constexpr uintptr_t kMark = 1;
+
+    struct Node : Reclaimer::Node {
+        const int key;
+        const int height;
+        std::atomic<int> refs{2};          // Inserter and remover
+        std::atomic<uintptr_t>* const next; // Per level: pointer | kMark
+
+        Node(int k, int h) : key(k), height(h), next(new std::atomic<uintptr_t>[h]()) {}
+        ~Node() { delete[] next; }
+    };
+
+    Reclaimer& reclaimer;
+    Node* const head; // Sentinel below every key
+
+    static uintptr_t link(Node* node) { return reinterpret_cast<uintptr_t>(node); }
+    static Node* address(uintptr_t field) { return reinterpret_cast<Node*>(field & ~kMark); }
+
+    static int randomLevel() {
+        thread_local std::mt19937 gen(std::random_device{}());
+        return __builtin_ctz(gen() | (1u << (kMaxLevel - 1))) + 1;
+    }
+
+    // Per level, the last node with a key < key and the one after it, unlinking
+    // marked nodes on the way. Returns whether level 0 holds key.
+    bool find(int key, Node** preds, Node** succs) {
+    retry:
+        Node* pred = head;
+        for (int level = kMaxLevel - 1; level >= 0; --level) {
+            Node* curr = address(pred->next[level].load(std::memory_order_acquire));
+            while (curr) {
+                uintptr_t succ = curr->next[level].load(std::memory_order_acquire);
+                if (succ & kMark) {
+                    uintptr_t expected = link(curr);
+                    if (!pred->next[level].compare_exchange_strong(expected, succ & ~kMark)) {
+                        goto retry; // pred changed or was itself marked
+                    }
+                    curr = address(succ);
+                    continue;
+                }
+                if (!(curr->key < key)) break;
+                pred = curr;
+                curr = address(succ);
+            }
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        return succs[0] && succs[0]->key == key;
+    }
+
+    // First level-0 node with a key >= key, marked or not
+    Node* lowerBound(int key) {
+        Node* pred = head;
+        Node* curr = nullptr;
+        for (int level = kMaxLevel - 1; level >= 0; --level) {
+            curr = address(pred->next[level].load(std::memory_order_acquire));
+            while (curr && curr->key < key) {
+                pred = curr;
+                curr = address(curr->next[level].load(std::memory_order_acquire));
+            }
+        }
+        return curr;
+    }
+
+    void release(Node* node, int tid) {
+        if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            reclaimer.retire(node, tid);
+        }
+    }
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Lock policies for SGLUnorderedMap. Each takes the thread count at
+// construction and lock(tid) / unlock(tid), so queue locks can keep their
+// per-thread nodes in an array instead of thread_local storage.
+//   CASLock     compare-and-swap on one word, no backoff (the original lock)
+//   TASLock     test-and-test-and-set with exponential backoff
+//   TicketLock  FIFO; waiters spin on the now-serving counter
+//   MCSLock     FIFO queue; each waiter spins on its own node
+//   CLHLock     FIFO queue; each waiter spins on its predecessor's node
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+// Spin hint that yields every so often, so a waiter on an oversubscribed
+// machine still lets a descheduled holder run
+inline void spinWait(int& spins) {
+    if (++spins % 1024 == 0) std::this_thread::yield();
+    else cpuRelax();
+}
+
+class CASLock {
+public:
+    explicit CASLock(int) {}
+
+    void lock(int tid) {
+        int unlk = -1;
+        while (!owner.compare_exchange_strong(unlk, tid, std::memory_order_acq_rel)) {
+            unlk = -1; // compare_exchange puts the old value into unlk, so set it back
+        }
+    }
+
+    void unlock(int) { owner.store(-1, std::memory_order_release); }
+
+    static const char* name() { return "CAS"; }
+
+private:
+    alignas(64) std::atomic<int> owner{-1};
+};
+
+class TASLock {
+public:
+    explicit TASLock(int) {}
+
+    void lock(int) {
+        int delay = kMinDelay;
+        while (true) {
+            int spins = 0;
+            while (locked.load(std::memory_order_relaxed)) spinWait(spins);
+            if (!locked.exchange(true, std::memory_order_acquire)) return;
+            // Lost the race after seeing it free: back off before rereading
+            for (int i = 0; i < delay; ++i) cpuRelax();
+            delay = std::min(delay * 2, kMaxDelay);
+        }
+    }
+
+    void unlock(int) { locked.store(false, std::memory_order_release); }
+
+    static const char* name() { return "TAS+backoff"; }
+
+private:
+    static constexpr int kMinDelay = 4;
+    static constexpr int kMaxDelay = 4096;
+
+    alignas(64) std::atomic<bool> locked{false};
+};
+
+class TicketLock {
+public:
+    explicit TicketLock(int) {}
+
+    void lock(int) {
+        uint32_t ticket = next.fetch_add(1, std::memory_order_relaxed);
+        int spins = 0;
+        while (serving.load(std::memory_order_acquire) != ticket) spinWait(spins);
+    }
+
+    void unlock(int) { serving.store(serving.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    static const char* name() { return "Ticket"; }
+
+private:
+    alignas(64) std::atomic<uint32_t> next{0};
+    alignas(64) std::atomic<uint32_t> serving{0};
+};
+
+class MCSLock {
+public:
+    explicit MCSLock(int threads) : nodes(threads) {}
+
+    void lock(int tid) {
+        QNode* me = &nodes[tid];
+        me->next.store(nullptr, std::memory_order_relaxed);
+        me->locked.store(true, std::memory_order_relaxed);
+        QNode* pred = tail.exchange(me, std::memory_order_acq_rel);
+        if (!pred) return;
+        pred->next.store(me, std::memory_order_release);
+        int spins = 0;
+        while (me->locked.load(std::memory_order_acquire)) spinWait(spins);
+    }
+
+    void unlock(int tid) {
+        QNode* me = &nodes[tid];
+        QNode* succ = me->next.load(std::memory_order_acquire);
+        if (!succ) {
+            QNode* expected = me;
+            if (tail.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) return;
+            // A successor swapped itself in but has not linked behind us yet
+            int spins = 0;
+            while (!(succ = me->next.load(std::memory_order_acquire))) spinWait(spins);
+        }
+        succ->locked.store(false, std::memory_order_release);
+    }
+
+    static const char* name() { return "MCS"; }
+
+private:
+    struct alignas(64) QNode {
+        std::atomic<QNode*> next{nullptr};
+        std::atomic<bool> locked{false};
+    };
+
+    std::vector<QNode> nodes;
+    alignas(64) std::atomic<QNode*> tail{nullptr};
+};
+
+class CLHLock {
+public:
+    // One node per thread plus the initial unlocked one; threads trade nodes
+    // with their predecessors, so the set in use never changes
+    explicit CLHLock(int threads) : pool(threads + 1), slots(threads) {
+        for (int i = 0; i < threads; ++i) slots[i].node = &pool[i];
+        tail.store(&pool[threads], std::memory_order_relaxed);
+    }
+
+    void lock(int tid) {
+        Slot& s = slots[tid];
+        s.node->locked.store(true, std::memory_order_relaxed);
+        s.pred = tail.exchange(s.node, std::memory_order_acq_rel);
+        int spins = 0;
+        while (s.pred->locked.load(std::memory_order_acquire)) spinWait(spins);
+    }
+
+    void unlock(int tid) {
+        Slot& s = slots[tid];
+        s.node->locked.store(false, std::memory_order_release);
+        s.node = s.pred; // Ours may still be watched by the successor
+    }
+
+    static const char* name() { return "CLH"; }
+
+private:
+    struct alignas(64) QNode {
+        std::atomic<bool> locked{false};
+    };
+
+    struct alignas(64) Slot {
+        QNode* node = nullptr;
+        QNode* pred = nullptr;
+    };
+
+    std::vector<QNode> pool;
+    std::vector<Slot> slots;
+    alignas(64) std::atomic<QNode*> tail{nullptr};
+};
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+#include "harris_list.h"
+
+// Shalev-Shavit split-ordered hash map (JACM 2006). All entries live in one
+// Harris-Michael list sorted by bit-reversed hash, so the entries of bucket b
+// are exactly those of bucket b + size once the table doubles: growing never
+// moves a node, it only doubles the bucket count. Each bucket points at a
+// dummy node in the list and is initialized lazily by splicing its dummy in
+// after its parent's (b with the top bit cleared).
+//
+// Buckets sit in fixed-size segments allocated on first use, reached through
+// a directory. When the directory fills up a bigger copy replaces it and the
+// old one is retired through the reclaimer, like removed entries. Same
+// interface as SGLUnorderedMap.
+template <class K, class V, class Reclaimer>
+class SplitOrderedMap {
+    // Split-order position first; the key only breaks hash collisions
+    struct SplitKey {
+        uint64_t order; // Bit-reversed hash: odd for entries, even for dummies
+        K key;
+
+        bool operator<(const SplitKey& o) const { return order < o.order || (order == o.order && key < o.key); }
+        bool operator==(const SplitKey& o) const { return order == o.order && key == o.key; }
+    };
+
+    using List = HarrisMichaelList<Reclaimer, SplitKey, V>;
+    using Link = typename List::Link;
+    using Node = typename List::Node;
+
+    static constexpr size_t kSegmentSize = 64;  // Buckets per segment
+    static constexpr uintptr_t kFrozen = 1;     // Directory slot was copied into a newer directory
+    static constexpr long kLoadFactor = 2;      // Average entries per bucket before doubling
+
+    struct Segment {
+        std::atomic<Node*> buckets[kSegmentSize]; // Dummy node, or null if not initialized yet
+    };
+
+    struct Directory : Reclaimer::Node {
+        const size_t capacity;
+        std::atomic<uintptr_t>* const slots; // Segment* | kFrozen
+
+        explicit Directory(size_t c) : capacity(c), slots(new std::atomic<uintptr_t>[c]()) {}
+        ~Directory() { delete[] slots; } // Segments are owned by the map
+    };
+
+public:
+    explicit SplitOrderedMap(Reclaimer& reclaimer)
+        : reclaimer(reclaimer), head(0), size(2), count(0), directory(new Directory(1)) {
+        Node* dummy;
+        List::insertAt(reclaimer, head, SplitKey{0, K()}, V(), 0, &dummy);
+        Segment* segment = new Segment();
+        segment->buckets[0].store(dummy);
+        directory.load()->slots[0].store(reinterpret_cast<uintptr_t>(segment));
+    }
+
+    ~SplitOrderedMap() {
+        List::freeList(head);
+        Directory* dir = directory.load();
+        for (size_t i = 0; i < dir->capacity; ++i) {
+            delete reinterpret_cast<Segment*>(dir->slots[i].load() & ~kFrozen);
+        }
+        delete dir;
+    }
+
+    bool insert(K key, V val, int tid) {
+        reclaimer.enter(tid);
+        uint64_t hash = hashOf(key);
+        bool inserted = List::insertAt(reclaimer, bucket(hash, tid)->next, entryKey(hash, key), val, tid);
+        if (inserted) grew();
+        reclaimer.leave(tid);
+        return inserted;
+    }
+
+    std::optional<V> put(K key, V val, int tid) {
+        reclaimer.enter(tid);
+        uint64_t hash = hashOf(key);
+        std::optional<V> res = List::putAt(reclaimer, bucket(hash, tid)->next, entryKey(hash, key), val, tid);
+        if (!res) grew();
+        reclaimer.leave(tid);
+        return res;
+    }
+
+    std::optional<V> replace(K key, V val, int tid) {
+        reclaimer.enter(tid);
+        uint64_t hash = hashOf(key);
+        std::optional<V> res = List::replaceAt(reclaimer, bucket(hash, tid)->next, entryKey(hash, key), val, tid);
+        reclaimer.leave(tid);
+        return res;
+    }
+
+    std::optional<V> remove(K key, int tid) {
+        reclaimer.enter(tid);
+        uint64_t hash = hashOf(key);
+        std::optional<V> res = List::removeAt(reclaimer, bucket(hash, tid)->next, entryKey(hash, key), tid);
+        if (res) count.fetch_sub(1, std::memory_order_relaxed);
+        reclaimer.leave(tid);
+        return res;
+    }
+
+    std::optional<V> get(K key, int tid) {
+        reclaimer.enter(tid);
+        uint64_t hash = hashOf(key);
+        std::optional<V> res = List::getAt(bucket(hash, tid)->next, entryKey(hash, key));
+        reclaimer.leave(tid);
+        return res;
+    }
+
+private:
+    Reclaimer& reclaimer;
+    Link head;                         // Starts with the dummy of bucket 0
+    std::atomic<size_t> size;          // Bucket count, a power of two
+    std::atomic<long> count;           // Entries
+    std::atomic<Directory*> directory;
+
+    static uint64_t reverse(uint64_t x) {
+        x = __builtin_bswap64(x);
+        x = ((x & 0x0F0F0F0F0F0F0F0FULL) << 4) | ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL);
+        x = ((x & 0x3333333333333333ULL) << 2) | ((x >> 2) & 0x3333333333333333ULL);
+        x = ((x & 0x5555555555555555ULL) << 1) | ((x >> 1) & 0x5555555555555555ULL);
+        return x;
+    }
+
+    // The top bit is reserved to tell entries from dummies
+    static uint64_t hashOf(const K& key) { return std::hash<K>()(key) & ~(1ULL << 63); }
+    static SplitKey entryKey(uint64_t hash, const K& key) { return SplitKey{reverse(hash | (1ULL << 63)), key}; }
+
+    // Double the bucket count once the load factor is exceeded
+    void grew() {
+        long n = count.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t s = size.load(std::memory_order_relaxed);
+        if (n > static_cast<long>(s) * kLoadFactor) {
+            size.compare_exchange_strong(s, s * 2);
+        }
+    }
+
+    // Dummy node of the bucket hash falls in, initializing the bucket if needed
+    Node* bucket(uint64_t hash, int tid) {
+        return initBucket(hash & (size.load(std::memory_order_acquire) - 1), tid);
+    }
+
+    Node* initBucket(size_t b, int tid) {
+        std::atomic<Node*>& slot = bucketSlot(b, tid);
+        Node* dummy = slot.load(std::memory_order_acquire);
+        if (dummy) return dummy;
+        size_t parent = b & ~(size_t(1) << (63 - __builtin_clzll(b)));
+        Node* parentDummy = initBucket(parent, tid);
+        // Racing initializers all end up with the one dummy that made it into the list
+        List::insertAt(reclaimer, parentDummy->next, SplitKey{reverse(b), K()}, V(), tid, &dummy);
+        slot.store(dummy, std::memory_order_release);
+        return dummy;
+    }
+
+    // Segments never move, so the slot stays valid after leave
+    std::atomic<Node*>& bucketSlot(size_t b, int tid) {
+        size_t index = b / kSegmentSize;
+        while (true) {
+            Directory* dir = directory.load(std::memory_order_acquire);
+            if (index >= dir->capacity) {
+                growDirectory(dir, index + 1, tid);
+                continue;
+            }
+            uintptr_t entry = dir->slots[index].load(std::memory_order_acquire);
+            if (entry == 0) {
+                Segment* segment = new Segment();
+                if (!dir->slots[index].compare_exchange_strong(entry, reinterpret_cast<uintptr_t>(segment))) {
+                    delete segment; // Never published
+                    continue;
+                }
+                entry = reinterpret_cast<uintptr_t>(segment);
+            } else if (entry == kFrozen) {
+                growDirectory(dir, index + 1, tid); // Help publish the copy instead of waiting for it
+                continue;
+            }
+            return reinterpret_cast<Segment*>(entry & ~kFrozen)->buckets[b % kSegmentSize];
+        }
+    }
+
+    // Freezing each slot while copying it stops late segment installs from
+    // landing in the old directory and getting lost
+    void growDirectory(Directory* old, size_t needed, int tid) {
+        size_t capacity = old->capacity * 2;
+        while (capacity < needed) capacity *= 2;
+        Directory* dir = new Directory(capacity);
+        for (size_t i = 0; i < old->capacity; ++i) {
+            dir->slots[i].store(old->slots[i].fetch_or(kFrozen) & ~kFrozen, std::memory_order_relaxed);
+        }
+        if (directory.compare_exchange_strong(old, dir)) {
+            reclaimer.retire(old, tid);
+        } else {
+            delete dir; // Never published
+        }
+    }
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Open-addressing hash table in the style of Abseil's Swiss tables. Entries
+// live inline in one slot array, so there is no allocation per entry and no
+// pointer to chase. Every slot has a control byte: empty, deleted, or the
+// low 7 bits of the key's hash. Probing goes 16 slots at a time: one SSE2
+// compare and _mm_movemask_epi8 turn a group of control bytes into a bitmask
+// of candidate slots, so a lookup usually reads one group and one slot.
+//
+// Not thread-safe; SGLUnorderedMap only touches it under its lock. K and V
+// must be default-constructible.
+template <class K, class V, class Hash = std::hash<K>>
+class SwissTable {
+public:
+    SwissTable() { rehash(kGroup); }
+
+    V* find(const K& key) {
+        size_t i = locate(key);
+        return i == kNone ? nullptr : &slots[i].second;
+    }
+
+    // Adds key if absent; returns its value and whether it was added
+    std::pair<V*, bool> emplace(const K& key, const V& val) {
+        if (V* v = find(key)) return {v, false};
+        if (growthLeft == 0) {
+            // Double if live entries are the problem, else just clear tombstones
+            rehash(count * 16 > capacity() * 7 ? capacity() * 2 : capacity());
+        }
+        size_t i = place(key, val);
+        return {&slots[i].second, true};
+    }
+
+    bool erase(const K& key) {
+        size_t i = locate(key);
+        if (i == kNone) return false;
+        ctrl[i] = kDeleted; // A tombstone, so probes for later keys in the group carry on
+        --count;
+        return true;
+    }
+
+    size_t size() const { return count; }
+
+    // Pulls in the first group key probes, control bytes and slots, so a
+    // batch of lookups can have all its misses in flight at once
+    void prefetch(const K& key) const {
+        size_t g = (hashOf(key) >> 7) & groupMask;
+        __builtin_prefetch(&ctrl[g * kGroup]);
+        __builtin_prefetch(&slots[g * kGroup]);
+    }
+
+private:
+    static constexpr size_t kGroup = 16;
+    static constexpr size_t kNone = SIZE_MAX;
+    static constexpr int8_t kEmpty = -128; // 0b10000000
+    static constexpr int8_t kDeleted = -2; // 0b11111110; full slots are 0b0xxxxxxx
+
+    std::vector<int8_t> ctrl;
+    std::vector<std::pair<K, V>> slots;
+    size_t groupMask = 0;
+    size_t count = 0;
+    size_t growthLeft = 0; // Empty slots we may still fill before rehashing
+
+    size_t capacity() const { return ctrl.size(); }
+
+    static uint64_t hashOf(const K& key) {
+        uint64_t h = static_cast<uint64_t>(Hash()(key)) * 0x9E3779B97F4A7C15ull;
+        return h ^ (h >> 32);
+    }
+
+    // Bit i set where group[i] == byte
+    static uint32_t match(const int8_t* group, int8_t byte) {
+#ifdef __SSE2__
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(byte)));
+#else
+        uint32_t bits = 0;
+        for (size_t i = 0; i < kGroup; ++i) bits |= static_cast<uint32_t>(group[i] == byte) << i;
+        return bits;
+#endif
+    }
+
+    // Bit i set where group[i] is empty or deleted (the sign bit)
+    static uint32_t matchFree(const int8_t* group) {
+#ifdef __SSE2__
+        return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)));
+#else
+        uint32_t bits = 0;
+        for (size_t i = 0; i < kGroup; ++i) bits |= static_cast<uint32_t>(group[i] < 0) << i;
+        return bits;
+#endif
+    }
+
+    // Triangular probing over groups visits every group once the group
+    // count is a power of two, and there is always an empty slot somewhere
+    size_t locate(const K& key) const {
+        uint64_t h = hashOf(key);
+        int8_t h2 = h & 0x7F;
+        size_t g = (h >> 7) & groupMask;
+        for (size_t step = 1;; ++step) {
+            const int8_t* group = &ctrl[g * kGroup];
+            for (uint32_t m = match(group, h2); m; m &= m - 1) {
+                size_t i = g * kGroup + __builtin_ctz(m);
+                if (slots[i].first == key) return i;
+            }
+            if (match(group, kEmpty)) return kNone;
+            g = (g + step) & groupMask;
+        }
+    }
+
+    // Puts a key known to be absent in the first free slot on its probe path
+    size_t place(const K& key, const V& val) {
+        uint64_t h = hashOf(key);
+        size_t g = (h >> 7) & groupMask;
+        for (size_t step = 1;; ++step) {
+            if (uint32_t m = matchFree(&ctrl[g * kGroup])) {
+                size_t i = g * kGroup + __builtin_ctz(m);
+                if (ctrl[i] == kEmpty) --growthLeft;
+                ctrl[i] = h & 0x7F;
+                slots[i] = {key, val};
+                ++count;
+                return i;
+            }
+            g = (g + step) & groupMask;
+        }
+    }
+
+    void rehash(size_t newCapacity) {
+        std::vector<int8_t> oldCtrl(newCapacity, kEmpty);
+        std::vector<std::pair<K, V>> oldSlots(newCapacity);
+        oldCtrl.swap(ctrl);
+        oldSlots.swap(slots);
+        groupMask = newCapacity / kGroup - 1;
+        count = 0;
+        growthLeft = newCapacity * 7 / 8;
+        for (size_t i = 0; i < oldCtrl.size(); ++i) {
+            if (oldCtrl[i] >= 0) place(oldSlots[i].first, oldSlots[i].second);
+        }
+    }
+};
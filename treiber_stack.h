@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+
+// Treiber lock-free stack (1986). A popped node is retired rather than freed,
+// so its address cannot come back while another pop still holds it: that is
+// what keeps the top CAS free of ABA without tags.
+template <class Reclaimer>
+class TreiberStack {
+public:
+    explicit TreiberStack(Reclaimer& reclaimer) : reclaimer(reclaimer), top(nullptr) {}
+
+    ~TreiberStack() {
+        Node* curr = top.load();
+        while (curr) {
+            Node* next = curr->next;
+            delete curr;
+            curr = next;
+        }
+    }
+
+    // Never dereferences shared nodes, so it needs no critical section
+    void push(int value, int) {
+        Node* node = new Node(value);
+        node->next = top.load(std::memory_order_relaxed);
+        while (!top.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::optional<int> pop(int tid) {
+        reclaimer.enter(tid);
+        std::optional<int> res;
+        Node* node = top.load(std::memory_order_acquire);
+        while (node && !top.compare_exchange_weak(node, node->next, std::memory_order_acquire)) {
+        }
+        if (node) {
+            res = node->value;
+            reclaimer.retire(node, tid);
+        }
+        reclaimer.leave(tid);
+        return res;
+    }
+
+private:
+    struct Node : Reclaimer::Node {
+        const int value;
+        Node* next = nullptr;
+
+        explicit Node(int v) : value(v) {}
+    };
+
+    Reclaimer& reclaimer;
+    std::atomic<Node*> top;
+};